@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Compares a loop over rb_insert with rb_insert_batch, on nearly sorted and
+// on random batches inserted into a tree that already holds many keys.
+// Usage: rb_bench_batch [keys] [batch size] [batches]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x2545F4914F6CDD1DULL;
+
+static unsigned long long rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static RB_Tree *make_tree(size_t n)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    rng_state = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, (int)(rng_next() % 0x7FFFFFFF));
+    }
+    return tree;
+}
+
+static void fill_batches(int *keys, size_t batch, size_t batches, int sorted)
+{
+    for (size_t b = 0; b < batches; b++)
+    {
+        int *run = keys + b * batch;
+        int base = (int)(rng_next() % 0x70000000);
+        for (size_t i = 0; i < batch; i++)
+        {
+            run[i] = sorted ? base + (int)(i * 64 + rng_next() % 64)
+                            : (int)(rng_next() % 0x7FFFFFFF);
+        }
+
+        // A few keys out of place, as delivered by the ingest path
+        for (size_t i = 0; sorted && i < batch / 128; i++)
+        {
+            size_t a = rng_next() % batch;
+            size_t c = rng_next() % batch;
+            int tmp = run[a];
+            run[a] = run[c];
+            run[c] = tmp;
+        }
+    }
+}
+
+static void run(const char *name, size_t n, const int *keys, size_t batch,
+                size_t batches)
+{
+    RB_Tree *tree = make_tree(n);
+    double start = now_ns();
+    for (size_t i = 0; i < batch * batches; i++)
+    {
+        rb_insert(tree, keys[i]);
+    }
+    double loop_ns = (now_ns() - start) / (batch * batches);
+    size_t loop_size = rb_tree_size(tree);
+    rb_tree_destroy(tree);
+
+    tree = make_tree(n);
+    start = now_ns();
+    for (size_t b = 0; b < batches; b++)
+    {
+        rb_insert_batch(tree, keys + b * batch, batch, NULL);
+    }
+    double batch_ns = (now_ns() - start) / (batch * batches);
+    size_t batch_size = rb_tree_size(tree);
+    rb_tree_destroy(tree);
+
+    printf("%-14s %14.1f %14.1f %8.2fx %s\n", name, loop_ns, batch_ns,
+           loop_ns / batch_ns, loop_size == batch_size ? "" : "MISMATCH");
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t batch = argc > 2 ? strtoul(argv[2], NULL, 10) : 16384;
+    size_t batches = argc > 3 ? strtoul(argv[3], NULL, 10) : 64;
+
+    int *keys = malloc(batch * batches * sizeof(int));
+    if (!keys)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_batch)\n");
+        return 1;
+    }
+
+    printf("tree keys=%zu batch=%zu batches=%zu\n", n, batch, batches);
+    printf("%-14s %14s %14s %9s\n", "batch", "rb_insert ns", "batch ns",
+           "speedup");
+    fill_batches(keys, batch, batches, 1);
+    run("nearly sorted", n, keys, batch, batches);
+    fill_batches(keys, batch, batches, 0);
+    run("random", n, keys, batch, batches);
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+#include "../rb_tree_define.h"
+
+// Compares the descent driven by compEQ then compLT (two comparisons per
+// level) with the descent driven by compCMP (one comparison per level), on
+// the int tree and on a tree of string keys where comparisons are costly.
+// Usage: rb_bench_compare [keys] [lookups]
+
+static size_t comparisons;
+
+static int string_cmp(const char *a, const char *b)
+{
+    comparisons++;
+    return strcmp(a, b);
+}
+
+RB_TREE_DEFINE(str_set, const char *, int, string_cmp)
+
+static str_set_node *str_find_two_way(str_set_tree *tree, const char *key)
+{
+    str_set_node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        if (string_cmp(key, current->key) == 0)
+        {
+            return current;
+        }
+        current =
+            string_cmp(key, current->key) < 0 ? current->left : current->right;
+    }
+    return NULL;
+}
+
+static RB_Node *find_two_way(RB_Tree *tree, T data)
+{
+    RB_Node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        if (compEQ(data, current->data))
+        {
+            return current;
+        }
+        current = compLT(data, current->data) ? current->left : current->right;
+    }
+    return NULL;
+}
+
+static RB_Node *find_two_way_counted(RB_Tree *tree, T data)
+{
+    RB_Node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        comparisons++;
+        if (compEQ(data, current->data))
+        {
+            return current;
+        }
+        comparisons++;
+        current = compLT(data, current->data) ? current->left : current->right;
+    }
+    return NULL;
+}
+
+static RB_Node *find_three_way_counted(RB_Tree *tree, T data)
+{
+    RB_Node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        comparisons++;
+        int cmp = compCMP(data, current->data);
+        if (cmp == 0)
+        {
+            return current;
+        }
+        current = cmp < 0 ? current->left : current->right;
+    }
+    return NULL;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : n;
+
+    int *keys = malloc(n * sizeof(int));
+    int *queries = malloc(lookups * sizeof(int));
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    if (!keys || !queries || !tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_compare)\n");
+        return 1;
+    }
+
+    // Even keys are present, odd keys are misses
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (int)(2 * i);
+    }
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        size_t j = rng_next() % (i + 1);
+        int tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, keys[i]);
+    }
+    for (size_t i = 0; i < lookups; i++)
+    {
+        queries[i] = (int)(rng_next() % (2 * n));
+    }
+
+    size_t found = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        found += find_two_way(tree, queries[i]) != NULL;
+    }
+    double two_way_ns = (now_ns() - start) / lookups;
+
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        found += rb_find(tree, queries[i]) != NULL;
+    }
+    double three_way_ns = (now_ns() - start) / lookups;
+
+    comparisons = 0;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        find_two_way_counted(tree, queries[i]);
+    }
+    double two_way_cmp = (double)comparisons / lookups;
+
+    comparisons = 0;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        find_three_way_counted(tree, queries[i]);
+    }
+    double three_way_cmp = (double)comparisons / lookups;
+
+    printf("int keys=%zu lookups=%zu hits=%zu\n", n, lookups, found / 2);
+    printf("%-24s %12s %12s\n", "descent", "cmp/lookup", "ns/lookup");
+    printf("%-24s %12.2f %12.1f\n", "compEQ + compLT", two_way_cmp,
+           two_way_ns);
+    printf("%-24s %12.2f %12.1f\n", "compCMP", three_way_cmp, three_way_ns);
+
+    rb_tree_destroy(tree);
+
+    // String keys share a long prefix, like paths or composite keys
+    size_t string_n = n / 10 ? n / 10 : 1;
+    size_t string_lookups = lookups / 10 ? lookups / 10 : 1;
+    char *strings = malloc(2 * string_n * 32);
+    str_set_tree *set = str_set_new();
+    if (!strings || !set)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_compare)\n");
+        return 1;
+    }
+    for (size_t i = 0; i < 2 * string_n; i++)
+    {
+        sprintf(strings + i * 32, "/index/shard/key-%012zu", i);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        if ((size_t)keys[i] < 2 * string_n)
+        {
+            str_set_insert(set, strings + keys[i] * 32, 0);
+        }
+    }
+
+    found = 0;
+    comparisons = 0;
+    start = now_ns();
+    for (size_t i = 0; i < string_lookups; i++)
+    {
+        found += str_find_two_way(set, strings + queries[i] % (2 * string_n)
+                                                     * 32)
+            != NULL;
+    }
+    two_way_cmp = (double)comparisons / string_lookups;
+    two_way_ns = (now_ns() - start) / string_lookups;
+
+    comparisons = 0;
+    start = now_ns();
+    for (size_t i = 0; i < string_lookups; i++)
+    {
+        found += str_set_find(set, strings + queries[i] % (2 * string_n) * 32)
+            != NULL;
+    }
+    three_way_cmp = (double)comparisons / string_lookups;
+    three_way_ns = (now_ns() - start) / string_lookups;
+
+    printf("string keys=%zu lookups=%zu hits=%zu\n", str_set_size(set),
+           string_lookups, found / 2);
+    printf("%-24s %12s %12s\n", "descent", "cmp/lookup", "ns/lookup");
+    printf("%-24s %12.2f %12.1f\n", "strcmp == 0, then < 0", two_way_cmp,
+           two_way_ns);
+    printf("%-24s %12.2f %12.1f\n", "strcmp once", three_way_cmp,
+           three_way_ns);
+
+    str_set_destroy(set);
+    free(strings);
+    free(queries);
+    free(keys);
+    return 0;
+}
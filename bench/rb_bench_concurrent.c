@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Measures lookup throughput for a growing number of reader threads while
+// one writer inserts or deletes a key every 10 microseconds, with
+// RB_Concurrent and with an RB_Tree behind a global mutex.
+// Usage: rb_bench_concurrent [keys] [max_threads] [milliseconds]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void pause_writer(void)
+{
+    struct timespec pause = { 0, 10000 };
+    nanosleep(&pause, NULL);
+}
+
+static unsigned long long rng_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+typedef struct
+{
+    RB_Concurrent *concurrent;
+    RB_Tree *tree;
+    pthread_mutex_t lock;
+    size_t keys;
+    volatile int stop;
+} Shared;
+
+typedef struct
+{
+    Shared *shared;
+    unsigned long long seed;
+    size_t lookups;
+    pthread_t thread;
+} Worker;
+
+static void *concurrent_reader(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    RB_Reader *reader = rb_concurrent_reader(shared->concurrent);
+    while (!shared->stop)
+    {
+        for (int i = 0; i < 1024; i++)
+        {
+            int key = (int)(rng_next(&worker->seed) % (2 * shared->keys));
+            rb_concurrent_find(reader, key, NULL);
+        }
+        worker->lookups += 1024;
+    }
+    rb_concurrent_reader_release(reader);
+    return NULL;
+}
+
+static void *concurrent_writer(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    while (!shared->stop)
+    {
+        int key = (int)(rng_next(&worker->seed) % (2 * shared->keys));
+        if (rb_concurrent_insert(shared->concurrent, key) == 0)
+        {
+            rb_concurrent_delete(shared->concurrent, key);
+        }
+        pause_writer();
+    }
+    return NULL;
+}
+
+static void *mutex_reader(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    while (!shared->stop)
+    {
+        for (int i = 0; i < 1024; i++)
+        {
+            int key = (int)(rng_next(&worker->seed) % (2 * shared->keys));
+            pthread_mutex_lock(&shared->lock);
+            rb_find(shared->tree, key);
+            pthread_mutex_unlock(&shared->lock);
+        }
+        worker->lookups += 1024;
+    }
+    return NULL;
+}
+
+static void *mutex_writer(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    while (!shared->stop)
+    {
+        int key = (int)(rng_next(&worker->seed) % (2 * shared->keys));
+        pthread_mutex_lock(&shared->lock);
+        RB_Node *node = rb_find(shared->tree, key);
+        if (node)
+        {
+            rb_delete(shared->tree, node);
+        }
+        else
+        {
+            rb_insert(shared->tree, key);
+        }
+        pthread_mutex_unlock(&shared->lock);
+        pause_writer();
+    }
+    return NULL;
+}
+
+/* Run readers and one writer for the given time, return lookups per second */
+static double run(Shared *shared, int readers, double ms,
+                  void *(*reader)(void *), void *(*writer)(void *))
+{
+    Worker *workers = calloc(readers + 1, sizeof(Worker));
+    if (!workers)
+    {
+        return 0;
+    }
+
+    shared->stop = 0;
+    for (int i = 0; i <= readers; i++)
+    {
+        workers[i].shared = shared;
+        workers[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&workers[i].thread, NULL, i ? reader : writer,
+                       &workers[i]);
+    }
+
+    struct timespec pause = { (time_t)(ms / 1000),
+                              (long)((ms - (long)(ms / 1000) * 1000) * 1e6) };
+    double start = now_ns();
+    nanosleep(&pause, NULL);
+    shared->stop = 1;
+
+    size_t lookups = 0;
+    for (int i = 0; i <= readers; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        lookups += workers[i].lookups;
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    free(workers);
+    return lookups / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    double ms = argc > 3 ? atof(argv[3]) : 500;
+
+    Shared shared;
+    shared.keys = keys;
+    shared.concurrent = rb_concurrent_new();
+    shared.tree = rb_tree_new_with_pool(keys);
+    if (!shared.concurrent || !shared.tree
+        || pthread_mutex_init(&shared.lock, NULL) != 0)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_concurrent)\n");
+        return 1;
+    }
+
+    unsigned long long seed = 42;
+    for (size_t i = 0; i < keys; i++)
+    {
+        int key = (int)(rng_next(&seed) % (2 * keys));
+        rb_concurrent_insert(shared.concurrent, key);
+        rb_insert(shared.tree, key);
+    }
+
+    printf("keys=%zu writer=1 seconds=%.2f\n", keys, ms / 1000);
+    printf("%8s %18s %18s\n", "readers", "concurrent Mop/s", "mutex Mop/s");
+    for (int readers = 1; readers <= max_threads; readers *= 2)
+    {
+        double concurrent = run(&shared, readers, ms, concurrent_reader,
+                                concurrent_writer);
+        double locked = run(&shared, readers, ms, mutex_reader, mutex_writer);
+        printf("%8d %18.2f %18.2f\n", readers, concurrent / 1e6,
+               locked / 1e6);
+    }
+
+    pthread_mutex_destroy(&shared.lock);
+    rb_concurrent_destroy(shared.concurrent);
+    rb_tree_destroy(shared.tree);
+    return 0;
+}
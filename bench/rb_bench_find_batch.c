@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Compares a loop over rb_find with rb_find_batch on a tree larger than the
+// last level cache, for several batch sizes.
+// Usage: rb_bench_find_batch [keys] [lookups]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 4000000;
+    size_t batch_sizes[] = { 16, 64, 256 };
+
+    int *queries = malloc(lookups * sizeof(int));
+    RB_Node **out = malloc(lookups * sizeof(RB_Node *));
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    if (!queries || !out || !tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_find_batch)\n");
+        return 1;
+    }
+
+    // Random insertion order scatters neighbouring keys across the pool
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, (int)(rng_next() % (4 * n)));
+    }
+    for (size_t i = 0; i < lookups; i++)
+    {
+        queries[i] = (int)(rng_next() % (4 * n));
+    }
+
+    size_t found = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        out[i] = rb_find(tree, queries[i]);
+        found += out[i] != NULL;
+    }
+    double loop_ns = (now_ns() - start) / lookups;
+
+    printf("tree keys=%zu lookups=%zu hits=%zu\n", rb_tree_size(tree),
+           lookups, found);
+    printf("%-16s %12s %9s\n", "lookup", "ns/lookup", "speedup");
+    printf("%-16s %12.1f %9s\n", "rb_find loop", loop_ns, "1.00x");
+
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++)
+    {
+        size_t batch = batch_sizes[b];
+        size_t batch_found = 0;
+        start = now_ns();
+        for (size_t i = 0; i < lookups; i += batch)
+        {
+            size_t count = lookups - i < batch ? lookups - i : batch;
+            batch_found += rb_find_batch(tree, queries + i, count, out + i);
+        }
+        double batch_ns = (now_ns() - start) / lookups;
+
+        char name[32];
+        sprintf(name, "batch of %zu", batch);
+        printf("%-16s %12.1f %8.2fx%s\n", name, batch_ns, loop_ns / batch_ns,
+               batch_found == found ? "" : " MISMATCH");
+    }
+
+    rb_tree_destroy(tree);
+    free(out);
+    free(queries);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Compares rb_find on a tree with lookups on its frozen snapshots.
+// Usage: rb_bench_frozen [keys] [lookups]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 4000000;
+
+    int *queries = malloc(lookups * sizeof(int));
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    if (!queries || !tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_frozen)\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, (int)(rng_next() % (4 * n)));
+    }
+    for (size_t i = 0; i < lookups; i++)
+    {
+        queries[i] = (int)(rng_next() % (4 * n));
+    }
+
+    double start = now_ns();
+    RB_Frozen *frozen = rb_tree_freeze(tree);
+    double freeze_ms = (now_ns() - start) / 1e6;
+    if (!frozen)
+    {
+        return 1;
+    }
+
+    RB_FrozenBlocks *blocks = rb_tree_freeze_blocks(tree);
+    if (!blocks)
+    {
+        return 1;
+    }
+
+    size_t found = 0;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        found += rb_find(tree, queries[i]) != NULL;
+    }
+    double tree_ns = (now_ns() - start) / lookups;
+
+    size_t frozen_found = 0;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        frozen_found += rb_frozen_find(frozen, queries[i]) != NULL;
+    }
+    double frozen_ns = (now_ns() - start) / lookups;
+
+    size_t blocks_found = 0;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        blocks_found += rb_frozen_blocks_find(blocks, queries[i]) != NULL;
+    }
+    double blocks_ns = (now_ns() - start) / lookups;
+
+    printf("tree keys=%zu lookups=%zu hits=%zu freeze_ms=%.1f\n",
+           rb_tree_size(tree), lookups, found, freeze_ms);
+    printf("%-16s %12s %9s\n", "lookup", "ns/lookup", "speedup");
+    printf("%-16s %12.1f %9s\n", "rb_find", tree_ns, "1.00x");
+    printf("%-16s %12.1f %8.2fx%s\n", "rb_frozen_find", frozen_ns,
+           tree_ns / frozen_ns, frozen_found == found ? "" : " MISMATCH");
+
+    char name[32];
+    sprintf(name, "blocks (%s)", rb_frozen_blocks_isa(blocks));
+    printf("%-16s %12.1f %8.2fx%s\n", name, blocks_ns, tree_ns / blocks_ns,
+           blocks_found == found ? "" : " MISMATCH");
+
+    rb_frozen_blocks_destroy(blocks);
+    rb_frozen_destroy(frozen);
+    rb_tree_destroy(tree);
+    free(queries);
+    return 0;
+}
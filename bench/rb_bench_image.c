@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../rb_tree.h"
+
+// Measures how long a restart takes to get its keys back: inserting them one
+// by one, loading a saved image, and mapping the image. Then times random
+// lookups in the loaded tree and in the mapping.
+// Usage: rb_bench_image [keys] [lookups]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    int *keys = malloc(n * sizeof(int));
+    if (!keys)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_image)\n");
+        return 1;
+    }
+    unsigned long long seed = 42;
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (int)(rng_next(&seed) % (4 * n));
+    }
+
+    double start = now_ns();
+    RB_Tree *inserted = rb_tree_new_with_pool(n);
+    for (size_t i = 0; inserted && i < n; i++)
+    {
+        rb_insert(inserted, keys[i]);
+    }
+    double insert_ms = (now_ns() - start) / 1e6;
+
+    FILE *file = tmpfile();
+    if (!inserted || !file)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_image)\n");
+        return 1;
+    }
+    int fd = fileno(file);
+
+    start = now_ns();
+    rb_tree_save(inserted, fd);
+    double save_ms = (now_ns() - start) / 1e6;
+
+    lseek(fd, 0, SEEK_SET);
+    start = now_ns();
+    RB_Tree *loaded = rb_tree_load(fd);
+    double load_ms = (now_ns() - start) / 1e6;
+
+    start = now_ns();
+    RB_Mapped *mapped = rb_tree_map(fd);
+    double map_ms = (now_ns() - start) / 1e6;
+    if (!loaded || !mapped)
+    {
+        fprintf(stderr, "image could not be read back (rb_bench_image)\n");
+        return 1;
+    }
+
+    printf("keys=%zu distinct=%zu image=%zu bytes\n", n,
+           rb_tree_size(loaded), 32 + rb_tree_size(loaded) * sizeof(int));
+    printf("%-24s %10.2f ms\n", "insert one by one", insert_ms);
+    printf("%-24s %10.2f ms\n", "rb_tree_save", save_ms);
+    printf("%-24s %10.2f ms\n", "rb_tree_load", load_ms);
+    printf("%-24s %10.2f ms\n", "rb_tree_map", map_ms);
+
+    size_t hits = 0;
+    seed = 7;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        hits += rb_find(loaded, keys[rng_next(&seed) % n]) != NULL;
+    }
+    double tree_ns = (now_ns() - start) / lookups;
+
+    seed = 7;
+    start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        hits += rb_mapped_find(mapped, keys[rng_next(&seed) % n]) != NULL;
+    }
+    double mapped_ns = (now_ns() - start) / lookups;
+
+    printf("%-24s %10.1f ns\n", "rb_find (loaded)", tree_ns);
+    printf("%-24s %10.1f ns\n", "rb_mapped_find", mapped_ns);
+    printf("hits=%zu\n", hits);
+
+    rb_mapped_destroy(mapped);
+    rb_tree_destroy(loaded);
+    rb_tree_destroy(inserted);
+    fclose(file);
+    free(keys);
+    return 0;
+}
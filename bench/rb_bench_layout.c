@@ -0,0 +1,73 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Reports the node size, the peak memory and the lookup time of a tree built
+// from random keys. Build it with and without RB_COMPACT to compare layouts:
+//   make clean bench FEATURES="-DRB_ORDER_STATISTICS"
+//   make clean bench FEATURES="-DRB_ORDER_STATISTICS -DRB_COMPACT"
+// Usage: rb_bench_layout [keys] [lookups]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned long long rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 4000000;
+
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_layout)\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, (int)(rng_next() % (4 * n)));
+    }
+
+    size_t found = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        found += rb_find(tree, (int)(rng_next() % (4 * n))) != NULL;
+    }
+    double lookup_ns = (now_ns() - start) / lookups;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef RB_COMPACT
+    const char *layout = "compact";
+#else
+    const char *layout = "default";
+#endif // RB_COMPACT
+    printf("layout=%s node_bytes=%zu nodes_per_line=%zu keys=%zu hits=%zu\n",
+           layout, sizeof(RB_Node), 64 / sizeof(RB_Node), rb_tree_size(tree),
+           found);
+    printf("peak_rss_kb=%ld lookup_ns=%.1f\n", usage.ru_maxrss, lookup_ns);
+
+    rb_tree_destroy(tree);
+    return 0;
+}
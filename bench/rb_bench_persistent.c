@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Measures the cost of updates on an RB_Persistent against a plain RB_Tree,
+// without snapshots and with a snapshot taken every few updates, which makes
+// the next updates copy the nodes they touch. Also times snapshot creation
+// and a full scan of a snapshot.
+// Usage: rb_bench_persistent [operations] [snapshot_every]
+
+#define KEY_SPACE (1 << 30)
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int count_visit(int data, void *ctx)
+{
+    (void)data;
+    ++*(size_t *)ctx;
+    return 0;
+}
+
+/* Insert keys then delete half of them, return ns per update */
+static double run_tree(size_t operations)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(operations);
+    if (!tree)
+    {
+        exit(1);
+    }
+
+    unsigned long long seed = 42;
+    double start = now_ns();
+    for (size_t i = 0; i < operations; i++)
+    {
+        rb_insert(tree, (int)(rng_next(&seed) % KEY_SPACE));
+    }
+    seed = 42;
+    for (size_t i = 0; i < operations; i += 2)
+    {
+        int key = (int)(rng_next(&seed) % KEY_SPACE);
+        rng_next(&seed);
+        rb_delete(tree, rb_find(tree, key));
+    }
+    double elapsed = now_ns() - start;
+
+    rb_tree_destroy(tree);
+    return elapsed / (operations + operations / 2);
+}
+
+/* Same updates on a persistent tree, holding the latest snapshot taken every
+ * snapshot_every updates (never when 0) */
+static double run_persistent(size_t operations, size_t snapshot_every)
+{
+    RB_Persistent *tree = rb_persistent_new();
+    if (!tree)
+    {
+        exit(1);
+    }
+
+    RB_Snapshot *snapshot = NULL;
+    unsigned long long seed = 42;
+    size_t updates = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < operations; i++, updates++)
+    {
+        if (snapshot_every && updates % snapshot_every == 0)
+        {
+            rb_snapshot_release(snapshot);
+            snapshot = rb_persistent_snapshot(tree);
+        }
+        rb_persistent_insert(tree, (int)(rng_next(&seed) % KEY_SPACE));
+    }
+    seed = 42;
+    for (size_t i = 0; i < operations; i += 2, updates++)
+    {
+        if (snapshot_every && updates % snapshot_every == 0)
+        {
+            rb_snapshot_release(snapshot);
+            snapshot = rb_persistent_snapshot(tree);
+        }
+        int key = (int)(rng_next(&seed) % KEY_SPACE);
+        rng_next(&seed);
+        rb_persistent_delete(tree, key);
+    }
+    double elapsed = now_ns() - start;
+
+    rb_snapshot_release(snapshot);
+    rb_persistent_destroy(tree);
+    return elapsed / updates;
+}
+
+int main(int argc, char **argv)
+{
+    size_t operations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t every = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+
+    printf("operations=%zu snapshot_every=%zu\n", operations, every);
+    printf("%-28s %10.1f ns/update\n", "RB_Tree", run_tree(operations));
+    printf("%-28s %10.1f ns/update\n", "RB_Persistent",
+           run_persistent(operations, 0));
+    printf("%-28s %10.1f ns/update\n", "RB_Persistent + snapshots",
+           run_persistent(operations, every));
+
+    RB_Persistent *tree = rb_persistent_new();
+    unsigned long long seed = 42;
+    for (size_t i = 0; tree && i < operations; i++)
+    {
+        rb_persistent_insert(tree, (int)(rng_next(&seed) % KEY_SPACE));
+    }
+
+    size_t rounds = 1000000;
+    double start = now_ns();
+    for (size_t i = 0; i < rounds; i++)
+    {
+        rb_snapshot_release(rb_persistent_snapshot(tree));
+    }
+    printf("%-28s %10.1f ns\n", "snapshot + release",
+           (now_ns() - start) / rounds);
+
+    RB_Snapshot *snapshot = rb_persistent_snapshot(tree);
+    size_t count = 0;
+    start = now_ns();
+    rb_snapshot_visit(snapshot, count_visit, &count);
+    printf("%-28s %10.1f ns/key (%zu keys)\n", "snapshot scan",
+           (now_ns() - start) / (count ? count : 1), count);
+
+    rb_snapshot_release(snapshot);
+    rb_persistent_destroy(tree);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../rb_tree.h"
+
+// Measures the union, intersection and difference of a tree of n random keys
+// below 2n with trees of 0.1% to 100% as many, by loops of rb_find,
+// rb_insert and rb_delete over the smaller tree and by rb_union,
+// rb_intersect and rb_difference on one thread and on every online processor.
+// Usage: rb_bench_set [keys]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Tree of count random keys below limit */
+static RB_Tree *random_tree(int count, int limit, unsigned seed)
+{
+    RB_Tree *tree = rb_tree_new();
+    for (int i = 0; tree && i < count; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        rb_insert(tree, (int)((seed >> 4) % (unsigned)limit));
+    }
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_set)\n");
+        exit(1);
+    }
+    return tree;
+}
+
+/* The loop each operation replaces: b is walked and a updated, or for the
+ * intersection the keys of b found in a go to a new tree */
+static RB_Tree *loop(int op, RB_Tree *a, RB_Tree *b)
+{
+    RB_Tree *result = a;
+    if (op == 1)
+    {
+        result = rb_tree_new();
+    }
+    for (RB_Node *node = rb_first(b); node; node = rb_next(b, node))
+    {
+        if (op == 0)
+        {
+            rb_insert(a, node->data);
+        }
+        else if (op == 1)
+        {
+            if (rb_find(a, node->data))
+            {
+                rb_insert(result, node->data);
+            }
+        }
+        else
+        {
+            rb_delete(a, rb_find(a, node->data));
+        }
+    }
+    if (op == 1)
+    {
+        rb_tree_destroy(a);
+    }
+    rb_tree_destroy(b);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    double fractions[] = { 0.001, 0.01, 0.1, 1 };
+    const char *names[] = { "union", "intersect", "difference" };
+    RB_Tree *(*operations[])(RB_Tree *, RB_Tree *, unsigned) = {
+        rb_union, rb_intersect, rb_difference
+    };
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("keys=%d processors=%ld\n", n, online);
+    printf("%10s %10s %12s %12s %12s\n", "operation", "other", "loop ms",
+           "1 thread ms", "all ms");
+    for (int op = 0; op < 3; op++)
+    {
+        for (int f = 0; f < 4; f++)
+        {
+            int m = (int)(n * fractions[f]);
+            double times[3];
+            for (int run = 0; run < 3; run++)
+            {
+                RB_Tree *a = random_tree(n, 2 * n, 1);
+                RB_Tree *b = random_tree(m, 2 * n, 2);
+                double start = now_ns();
+                RB_Tree *result = run == 0 ? loop(op, a, b)
+                                : operations[op](a, b, run == 1 ? 1 : 0);
+                times[run] = now_ns() - start;
+                rb_tree_destroy(result);
+            }
+            printf("%10s %10d %12.2f %12.2f %12.2f\n", names[op], m,
+                   times[0] / 1e6, times[1] / 1e6, times[2] / 1e6);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Measures insert and delete throughput for 1 to 64 writer threads, with one
+// RB_Tree behind a global mutex and with an RB_Sharded of 64 shards splitting
+// the key space evenly.
+// Usage: rb_bench_sharded [operations] [max_threads]
+
+#define SHARDS 64
+#define KEY_SPACE (1 << 30)
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+typedef struct
+{
+    RB_Tree *tree;
+    pthread_mutex_t lock;
+    RB_Sharded *sharded;
+    size_t operations;
+} Shared;
+
+typedef struct
+{
+    Shared *shared;
+    unsigned long long seed;
+    pthread_t thread;
+} Worker;
+
+/* Insert keys, then delete half of them */
+static void *mutex_writer(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    unsigned long long seed = worker->seed;
+    for (size_t i = 0; i < shared->operations; i++)
+    {
+        int key = (int)(rng_next(&worker->seed) % KEY_SPACE);
+        pthread_mutex_lock(&shared->lock);
+        rb_insert(shared->tree, key);
+        pthread_mutex_unlock(&shared->lock);
+    }
+    for (size_t i = 0; i < shared->operations; i += 2)
+    {
+        int key = (int)(rng_next(&seed) % KEY_SPACE);
+        rng_next(&seed);
+        pthread_mutex_lock(&shared->lock);
+        rb_delete(shared->tree, rb_find(shared->tree, key));
+        pthread_mutex_unlock(&shared->lock);
+    }
+    return NULL;
+}
+
+static void *sharded_writer(void *arg)
+{
+    Worker *worker = arg;
+    Shared *shared = worker->shared;
+    unsigned long long seed = worker->seed;
+    for (size_t i = 0; i < shared->operations; i++)
+    {
+        int key = (int)(rng_next(&worker->seed) % KEY_SPACE);
+        rb_sharded_insert(shared->sharded, key);
+    }
+    for (size_t i = 0; i < shared->operations; i += 2)
+    {
+        int key = (int)(rng_next(&seed) % KEY_SPACE);
+        rng_next(&seed);
+        rb_sharded_delete(shared->sharded, key);
+    }
+    return NULL;
+}
+
+/* Run the writers, return operations per second */
+static double run(Shared *shared, int threads, void *(*writer)(void *))
+{
+    Worker workers[64];
+    double start = now_ns();
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].shared = shared;
+        workers[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&workers[i].thread, NULL, writer, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double seconds = (now_ns() - start) / 1e9;
+    return threads * (shared->operations + shared->operations / 2) / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    size_t operations = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 64;
+    if (max_threads > 64)
+    {
+        max_threads = 64;
+    }
+
+    int bounds[SHARDS - 1];
+    for (int i = 1; i < SHARDS; i++)
+    {
+        bounds[i - 1] = (int)((long long)KEY_SPACE * i / SHARDS);
+    }
+
+    printf("operations=%zu shards=%d\n", operations, SHARDS);
+    printf("%8s %16s %16s\n", "writers", "mutex Mop/s", "sharded Mop/s");
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        Shared shared;
+        shared.operations = operations / threads;
+        shared.tree = rb_tree_new_with_pool(operations);
+        shared.sharded = rb_sharded_new(bounds, SHARDS - 1);
+        if (!shared.tree || !shared.sharded
+            || pthread_mutex_init(&shared.lock, NULL) != 0)
+        {
+            fprintf(stderr, "insufficient memory (rb_bench_sharded)\n");
+            return 1;
+        }
+
+        double locked = run(&shared, threads, mutex_writer);
+        double sharded = run(&shared, threads, sharded_writer);
+        printf("%8d %16.2f %16.2f\n", threads, locked / 1e6, sharded / 1e6);
+
+        pthread_mutex_destroy(&shared.lock);
+        rb_tree_destroy(shared.tree);
+        rb_sharded_destroy(shared.sharded);
+    }
+    return 0;
+}
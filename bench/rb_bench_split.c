@@ -0,0 +1,78 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../rb_tree.h"
+
+// Measures moving the keys above a cut point of a tree into another tree,
+// by rb_split and by deleting and inserting them one by one, then joining
+// the two parts back with rb_concat, for cuts moving 0.1% to 50% of the keys.
+// Usage: rb_bench_split [keys]
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static RB_Tree *tree_of(int n)
+{
+    RB_Tree *tree = rb_tree_new();
+    for (int i = 0; tree && i < n; i++)
+    {
+        rb_insert(tree, (int)((i * 2654435761u) % (unsigned)n));
+    }
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_split)\n");
+        exit(1);
+    }
+    return tree;
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    double fractions[] = { 0.001, 0.01, 0.1, 0.5 };
+
+    printf("keys=%d\n", n);
+    printf("%10s %10s %14s %14s %14s\n", "moved", "keys", "rb_split us",
+           "reinsert us", "rb_concat us");
+    for (int f = 0; f < 4; f++)
+    {
+        int cut = n - (int)(n * fractions[f]);
+
+        RB_Tree *tree = tree_of(n);
+        RB_Tree *left;
+        RB_Tree *right;
+        double start = now_ns();
+        rb_split(tree, cut, &left, &right);
+        double split = now_ns() - start;
+
+        start = now_ns();
+        RB_Tree *joined = rb_concat(left, right);
+        double concat = now_ns() - start;
+        rb_tree_destroy(joined);
+
+        tree = tree_of(n);
+        RB_Tree *moved = rb_tree_new();
+        start = now_ns();
+        for (RB_Node *node = rb_lower_bound(tree, cut); node;)
+        {
+            RB_Node *next = rb_next(tree, node);
+            rb_insert(moved, node->data);
+            rb_delete(tree, node);
+            node = next;
+        }
+        double reinsert = now_ns() - start;
+        rb_tree_destroy(tree);
+        rb_tree_destroy(moved);
+
+        printf("%9.1f%% %10d %14.1f %14.1f %14.1f\n", fractions[f] * 100,
+               n - cut, split / 1e3, reinsert / 1e3, concat / 1e3);
+    }
+    return 0;
+}
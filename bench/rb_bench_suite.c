@@ -0,0 +1,419 @@
+#define _XOPEN_SOURCE 700
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../rb_tree.h"
+
+// Benchmark driver for regression tracking. For each workload and each size
+// from 1e3 up to max_size by powers of ten, measures rb_insert, rb_find,
+// rb_delete and rb_tree_destroy and prints one JSON object per line:
+//
+//   {"workload":"zipf","op":"find","size":1000000,"ops":1000000,
+//    "ns_per_op":412.3,"ops_per_s":2425000,"p50_ns":390,"p99_ns":1210,
+//    "p999_ns":2810,"peak_rss_kb":48210}
+//
+// Workloads:
+//   seq     keys 0..n-1 inserted, found and deleted in ascending order
+//   random  uniform random keys, lookups of uniformly chosen present keys
+//   zipf    uniform random keys, lookups and deletes of present keys chosen
+//           with a Zipfian skew (theta 0.99), repeated deletes being misses
+//   mixed   random keys, then n operations: 80% find, 10% insert, 10% delete
+//
+// ns_per_op and ops_per_s come from the time of a whole phase. Percentiles
+// come from up to 65536 operations timed one by one, evenly spread over the
+// phase, less the cost of reading the clock: they are latencies of isolated
+// operations, which overlap less with their neighbours than in the whole
+// phase and can exceed ns_per_op. Each run is a child process, so
+// peak_rss_kb is the peak of that run alone. destroy reports the time per
+// node and no percentiles. A size of 1e8 needs about 5 GB.
+// Usage: rb_bench_suite [max_size] [workload...]
+//        make bench_run BENCH_MAX=100000000 > results.jsonl
+
+#define MIN_SIZE 1000
+#define SAMPLES (1 << 16)
+#define ZIPF_THETA 0.99
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static double rng_uniform(unsigned long long *state)
+{
+    return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Zipfian ranks in 0..n-1, rank 0 being the most frequent (Gray et al.,
+// "Quickly generating billion-record synthetic databases")
+
+typedef struct
+{
+    size_t n;
+    double zetan;
+    double alpha;
+    double eta;
+    double half_pow_theta;
+} Zipf;
+
+static void zipf_init(Zipf *zipf, size_t n)
+{
+    double zetan = 0;
+    for (size_t i = 1; i <= n; i++)
+    {
+        zetan += 1 / pow((double)i, ZIPF_THETA);
+    }
+    double zeta2 = 1 + 1 / pow(2, ZIPF_THETA);
+
+    zipf->n = n;
+    zipf->zetan = zetan;
+    zipf->alpha = 1 / (1 - ZIPF_THETA);
+    zipf->eta = (1 - pow(2.0 / n, 1 - ZIPF_THETA)) / (1 - zeta2 / zetan);
+    zipf->half_pow_theta = pow(0.5, ZIPF_THETA);
+}
+
+static size_t zipf_next(const Zipf *zipf, unsigned long long *state)
+{
+    double u = rng_uniform(state);
+    double uz = u * zipf->zetan;
+    if (uz < 1)
+    {
+        return 0;
+    }
+    if (uz < 1 + zipf->half_pow_theta)
+    {
+        return 1;
+    }
+    size_t rank = (size_t)(zipf->n * pow(zipf->eta * u - zipf->eta + 1,
+                                         zipf->alpha));
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+// Measurement
+
+typedef struct
+{
+    const char *workload;
+    size_t size;
+    unsigned long long samples[SAMPLES];
+    size_t count;
+    size_t stride;
+    double sample_start;
+    double start;
+} Phase;
+
+/* Cost of reading the clock twice, removed from every timed operation */
+static double clock_overhead;
+
+static void calibrate_clock(void)
+{
+    clock_overhead = 1e9;
+    for (int i = 0; i < 10000; i++)
+    {
+        double start = now_ns();
+        double elapsed = now_ns() - start;
+        if (elapsed < clock_overhead)
+        {
+            clock_overhead = elapsed;
+        }
+    }
+}
+
+static void phase_begin(Phase *phase, size_t ops)
+{
+    phase->count = 0;
+    phase->stride = ops / SAMPLES + 1;
+    phase->start = now_ns();
+}
+
+/* Whether operation i is one of the timed ones, starting its clock if so */
+static int sample_begin(Phase *phase, size_t i)
+{
+    if (i % phase->stride != 0 || phase->count == SAMPLES)
+    {
+        return 0;
+    }
+    phase->sample_start = now_ns();
+    return 1;
+}
+
+static void sample_end(Phase *phase)
+{
+    double elapsed = now_ns() - phase->sample_start - clock_overhead;
+    phase->samples[phase->count++] =
+        elapsed > 0 ? (unsigned long long)elapsed : 0;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+static unsigned long long percentile(const Phase *phase, double p)
+{
+    size_t index = (size_t)(p * (phase->count - 1) + 0.5);
+    return phase->samples[index];
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void phase_end(Phase *phase, const char *op, size_t ops)
+{
+    double elapsed = now_ns() - phase->start;
+    double ns_per_op = ops ? elapsed / ops : 0;
+
+    printf("{\"workload\":\"%s\",\"op\":\"%s\",\"size\":%zu,\"ops\":%zu,"
+           "\"ns_per_op\":%.1f,\"ops_per_s\":%.0f,",
+           phase->workload, op, phase->size, ops, ns_per_op,
+           elapsed > 0 ? ops * 1e9 / elapsed : 0);
+    if (phase->count > 0)
+    {
+        qsort(phase->samples, phase->count, sizeof(phase->samples[0]),
+              compare_samples);
+        printf("\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,",
+               percentile(phase, 0.5), percentile(phase, 0.99),
+               percentile(phase, 0.999));
+    }
+    else
+    {
+        printf("\"p50_ns\":null,\"p99_ns\":null,\"p999_ns\":null,");
+    }
+    printf("\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+    fflush(stdout);
+}
+
+// Workloads
+
+typedef enum
+{
+    SEQ,
+    RANDOM,
+    ZIPF,
+    MIXED
+} Workload;
+
+static const char *workload_names[] = { "seq", "random", "zipf", "mixed" };
+
+static int insert_all(Phase *phase, RB_Tree *tree, const int *keys, size_t n)
+{
+    phase_begin(phase, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        int timed = sample_begin(phase, i);
+        if (!rb_insert(tree, keys[i]))
+        {
+            return -1;
+        }
+        if (timed)
+        {
+            sample_end(phase);
+        }
+    }
+    phase_end(phase, "insert", n);
+    return 0;
+}
+
+/* Index of the key operation i looks up or deletes */
+static size_t pick(Workload workload, const Zipf *zipf, size_t n, size_t i,
+                   unsigned long long *seed)
+{
+    switch (workload)
+    {
+    case SEQ:
+        return i;
+    case ZIPF:
+        return zipf_next(zipf, seed);
+    default:
+        return rng_next(seed) % n;
+    }
+}
+
+/* Keeps the compiler from dropping lookups whose result is unused */
+static volatile size_t sink;
+
+static void run_mixed(Phase *phase, RB_Tree *tree, int *keys, size_t n,
+                      unsigned long long *seed)
+{
+    size_t found = 0;
+
+    phase_begin(phase, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned long long dice = rng_next(seed) % 10;
+        size_t index = rng_next(seed) % n;
+        int timed = sample_begin(phase, i);
+        if (dice < 8)
+        {
+            found += rb_find(tree, keys[index]) != NULL;
+        }
+        else if (dice == 8)
+        {
+            rb_delete(tree, rb_find(tree, keys[index]));
+        }
+        else
+        {
+            keys[index] = (int)(rng_next(seed) % (4 * n));
+            rb_insert(tree, keys[index]);
+        }
+        if (timed)
+        {
+            sample_end(phase);
+        }
+    }
+    phase_end(phase, "mixed", n);
+    sink = found;
+}
+
+static int run(Workload workload, size_t n)
+{
+    static Phase phase;
+    phase.workload = workload_names[workload];
+    phase.size = n;
+
+    int *keys = malloc(n * sizeof(int));
+    RB_Tree *tree = rb_tree_new();
+    if (!keys || !tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_suite)\n");
+        return 1;
+    }
+
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL ^ n;
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = workload == SEQ ? (int)i
+                                  : (int)(rng_next(&seed) % (4 * n));
+    }
+    Zipf zipf = { 0, 0, 0, 0, 0 };
+    if (workload == ZIPF)
+    {
+        zipf_init(&zipf, n);
+    }
+
+    if (insert_all(&phase, tree, keys, n) != 0)
+    {
+        fprintf(stderr, "insufficient memory (rb_bench_suite)\n");
+        return 1;
+    }
+
+    if (workload == MIXED)
+    {
+        run_mixed(&phase, tree, keys, n, &seed);
+    }
+    else
+    {
+        size_t found = 0;
+        phase_begin(&phase, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            int key = keys[pick(workload, &zipf, n, i, &seed)];
+            int timed = sample_begin(&phase, i);
+            found += rb_find(tree, key) != NULL;
+            if (timed)
+            {
+                sample_end(&phase);
+            }
+        }
+        phase_end(&phase, "find", n);
+        if (found != n)
+        {
+            fprintf(stderr, "lookups missed keys (rb_bench_suite)\n");
+            return 1;
+        }
+
+        phase_begin(&phase, n / 2);
+        for (size_t i = 0; i < n / 2; i++)
+        {
+            int key = keys[pick(workload, &zipf, n, i, &seed)];
+            int timed = sample_begin(&phase, i);
+            rb_delete(tree, rb_find(tree, key));
+            if (timed)
+            {
+                sample_end(&phase);
+            }
+        }
+        phase_end(&phase, "delete", n / 2);
+    }
+
+    size_t remaining = rb_tree_size(tree);
+    phase_begin(&phase, 0);
+    rb_tree_destroy(tree);
+    phase_end(&phase, "destroy", remaining);
+
+    free(keys);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_size = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    int selected[4] = { argc <= 2, argc <= 2, argc <= 2, argc <= 2 };
+    for (int i = 2; i < argc; i++)
+    {
+        int known = 0;
+        for (int w = 0; w < 4; w++)
+        {
+            if (strcmp(argv[i], workload_names[w]) == 0)
+            {
+                selected[w] = known = 1;
+            }
+        }
+        if (!known)
+        {
+            fprintf(stderr, "unknown workload %s (seq, random, zipf, mixed)\n",
+                    argv[i]);
+            return 1;
+        }
+    }
+
+    calibrate_clock();
+    for (size_t n = MIN_SIZE; n <= max_size; n *= 10)
+    {
+        for (int w = 0; w < 4; w++)
+        {
+            if (!selected[w])
+            {
+                continue;
+            }
+
+            // A child per run, so that its peak RSS is its own
+            pid_t child = fork();
+            if (child == 0)
+            {
+                exit(run((Workload)w, n));
+            }
+            int status;
+            if (child < 0 || waitpid(child, &status, 0) != child
+                || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "%s run of size %zu failed\n",
+                        workload_names[w], n);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
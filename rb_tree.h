@@ -3,6 +3,7 @@
 
 // Standard libraries
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,17 +11,27 @@
 
 /**
  * @brief Type of data stored in the tree (int, float, char, etc.)
- * @note This type must be comparable using the compLT and compEQ macros
+ * @note This type must be comparable using the compCMP macro, which the
+ * library uses for every comparison of keys
  * @note This typedef must be user specific
  */
 typedef int T;
 
+/**
+ * @brief Tells that T is int
+ * @note Enables the vector search of frozen blocks (rb_tree_freeze_blocks) on
+ * x86 processors. Remove it when T is changed to another type
+ * @note This define must be user specific
+ */
+#define RB_T_INT
+
 /**
  * @brief Function to compare two elements of type T
  * @param a First element
  * @param b Second element
- * @return 1 if a < b, 0 if a == b, -1 if a > b
- * @note This function must be user specific
+ * @return 1 if a < b, 0 otherwise
+ * @note The library does not use it, it is kept for the tests and benchmarks
+ * that compare against it. Keep it consistent with compCMP
  */
 #define compLT(a, b) (a < b)
 
@@ -29,21 +40,68 @@ typedef int T;
  * @param a First element
  * @param b Second element
  * @return 1 if a == b, 0 otherwise
- * @note This function must be user specific
+ * @note The library does not use it, it is kept for the tests and benchmarks
+ * that compare against it. Keep it consistent with compCMP
  */
 #define compEQ(a, b) (a == b)
 
+/**
+ * @brief Three-way comparison of two elements of type T
+ * @param a First element
+ * @param b Second element
+ * @return A negative value if a < b, 0 if a == b, a positive value if a > b
+ * @note This function must be user specific
+ * @note The tree is driven by this comparison only, so that a descent costs
+ * one comparison per node
+ * @note For scalar types the default folds into a single machine comparison,
+ * and the descent picks the child with a conditional move instead of a branch
+ */
+#define compCMP(a, b) ((a) == (b) ? 0 : ((a) < (b) ? -1 : 1))
+
+/**
+ * @brief Order statistics mode
+ * @note Define RB_ORDER_STATISTICS (e.g. make FEATURES=-DRB_ORDER_STATISTICS)
+ * to store the size of its subtree in every node and enable rb_select and
+ * rb_rank. When it is not defined, nodes and updates carry no extra cost
+ * @note This option must be the same for the library and its users
+ */
+
+/**
+ * @brief Compact node mode
+ * @note Define RB_COMPACT (e.g. make FEATURES=-DRB_COMPACT) to store the
+ * color of a node in the low bit of its parent pointer, and with
+ * RB_ORDER_STATISTICS to keep subtree sizes on 32 bits. This saves 8 bytes
+ * per node whenever T or the subtree size would otherwise pad the node, so
+ * that two nodes fit in a 64 bytes cache line
+ * @note Nodes must then be accessed through rb_parent, rb_color,
+ * rb_set_parent and rb_set_color, which also work without RB_COMPACT
+ * @note This option must be the same for the library and its users
+ */
+
+/**
+ * @brief Instrumentation mode
+ * @note Define RB_STATS (e.g. make FEATURES=-DRB_STATS) to count in every
+ * tree its rotations, fixup iterations and descents with their depths, read
+ * back with rb_tree_stats. When it is not defined, trees and operations carry
+ * no counter at all. With it, set operations such as rb_union run on one
+ * thread, so that the counters stay exact
+ * @note This option must be the same for the library and its users
+ */
+
 // Red black tree structure
 
 /**
  * @brief Color of a node
  * @note This enum is NOT user specific
  */
+#ifndef RB_COLOR_DEFINED
+#    define RB_COLOR_DEFINED
 typedef enum
 {
     BLACK,
     RED
 } RB_Color;
+#endif // RB_COLOR_DEFINED
 
 /**
  * @brief Node of the red black tree
@@ -52,21 +110,132 @@ typedef enum
  * @param parent Parent node
  * @param color Color of the node
  * @param data Data stored in the node
+ * @param parent_color Parent node with the color in its low bit (replaces
+ * parent and color with RB_COMPACT)
+ * @param size Number of nodes in the subtree rooted at this node (only with
+ * RB_ORDER_STATISTICS, 0 for the nil node)
  * @note This struct is NOT user specific
  */
 typedef struct RB_Node_
 {
     struct RB_Node_ *left;
     struct RB_Node_ *right;
+#ifdef RB_COMPACT
+    uintptr_t parent_color;
+#else
     struct RB_Node_ *parent;
     RB_Color color;
+#endif // RB_COMPACT
     T data;
+#ifdef RB_ORDER_STATISTICS
+#    ifdef RB_COMPACT
+    uint32_t size;
+#    else
+    size_t size;
+#    endif // RB_COMPACT
+#endif // RB_ORDER_STATISTICS
 } RB_Node;
 
+/**
+ * @brief Access the parent and the color of a node
+ * @param n Node
+ * @param p Parent node
+ * @param c Color (BLACK or RED)
+ * @note rb_set_parent keeps the color and rb_set_color keeps the parent,
+ * rb_set_parent_color sets both and suits freshly allocated nodes
+ */
+#ifdef RB_COMPACT
+#    define rb_parent(n) ((RB_Node *)((n)->parent_color & ~(uintptr_t)1))
+#    define rb_color(n) ((RB_Color)((n)->parent_color & 1))
+#    define rb_set_parent_color(n, p, c)                                     \
+        ((n)->parent_color = (uintptr_t)(p) | (uintptr_t)(c))
+#    define rb_set_parent(n, p)                                              \
+        ((n)->parent_color = (uintptr_t)(p) | ((n)->parent_color & 1))
+#    define rb_set_color(n, c)                                               \
+        ((n)->parent_color =                                                 \
+             ((n)->parent_color & ~(uintptr_t)1) | (uintptr_t)(c))
+#else
+#    define rb_parent(n) ((n)->parent)
+#    define rb_color(n) ((n)->color)
+#    define rb_set_parent_color(n, p, c) ((n)->parent = (p), (n)->color = (c))
+#    define rb_set_parent(n, p) ((n)->parent = (p))
+#    define rb_set_color(n, c) ((n)->color = (c))
+#endif // RB_COMPACT
+
+/**
+ * @brief Memory allocator used by a tree for its nodes and for itself
+ * @param alloc Allocate size bytes, return NULL on failure
+ * @param free Release a block previously returned by alloc, may be NULL when
+ * the memory is reclaimed by its owner (arenas, shared memory segments)
+ * @param ctx User context passed to alloc and free
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Allocator_
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} RB_Allocator;
+
+/**
+ * @brief Pool of nodes allocated in slabs
+ * @note This struct is opaque, see rb_tree_new_with_pool
+ */
+typedef struct RB_Pool_ RB_Pool;
+
+#ifdef RB_STATS
+/**
+ * @brief Number of buckets of the descent depth histogram, the last one
+ * gathering every deeper descent
+ */
+#    define RB_STATS_DEPTHS 64
+
+/**
+ * @brief Counters of a tree (only with RB_STATS)
+ * @param inserts Nodes inserted
+ * @param deletes Nodes deleted
+ * @param rotations_left Calls to rb_rotate_left
+ * @param rotations_right Calls to rb_rotate_right
+ * @param insert_fixups Iterations of the insert fixup loop
+ * @param delete_fixups Iterations of the delete fixup loop
+ * @param descents Searches walking down the tree: rb_find, rb_insert,
+ * rb_lower_bound, rb_upper_bound and rb_floor
+ * @param comparisons Keys compared by those descents
+ * @param depths Number of descents by number of keys compared
+ * @param size Number of nodes, filled in by rb_tree_stats
+ * @param height Number of nodes on the longest path from the root, filled in
+ * by rb_tree_stats
+ * @param black_height Number of black nodes on any path from the root, filled
+ * in by rb_tree_stats
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Stats_
+{
+    unsigned long inserts;
+    unsigned long deletes;
+    unsigned long rotations_left;
+    unsigned long rotations_right;
+    unsigned long insert_fixups;
+    unsigned long delete_fixups;
+    unsigned long descents;
+    unsigned long comparisons;
+    unsigned long depths[RB_STATS_DEPTHS];
+    size_t size;
+    size_t height;
+    size_t black_height;
+} RB_Stats;
+#endif // RB_STATS
+
 /**
  * @brief Red black tree
  * @param root Root node of the tree
  * @param nil Nil node of the tree
+ * @param size Number of nodes in the tree
+ * @param generation Number of changes made to the tree (insertions, deletions
+ * and overwrites), used to tell whether a frozen snapshot is still up to date
+ * @param allocator Allocator of the tree
+ * @param pool Node pool of the tree, or NULL if nodes are allocated one by one
+ * @param stats Counters of the tree (only with RB_STATS)
  * @note This struct is NOT user specific
  * @note The nil node is used to avoid special cases when a node has no child or
  * no parent
@@ -75,8 +244,107 @@ typedef struct RB_Tree_
 {
     RB_Node *root;
     RB_Node nil;
+    size_t size;
+    unsigned long generation;
+    RB_Allocator allocator;
+    RB_Pool *pool;
+#ifdef RB_STATS
+    RB_Stats stats;
+#endif // RB_STATS
 } RB_Tree;
 
+/**
+ * @brief Immutable, pointer free copy of the keys of a tree laid out for
+ * searching (see rb_tree_freeze)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Frozen_ RB_Frozen;
+
+/**
+ * @brief Immutable copy of the keys of a tree laid out as a static B-tree of
+ * 16 keys blocks (see rb_tree_freeze_blocks)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_FrozenBlocks_ RB_FrozenBlocks;
+
+/**
+ * @brief Tree shared between threads: writers take turns on a lock, readers
+ * take no lock (see rb_concurrent_new)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Concurrent_ RB_Concurrent;
+
+/**
+ * @brief Registration of a reader thread with a concurrent tree
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Reader_ RB_Reader;
+
+/**
+ * @brief Set of trees each holding a range of keys behind its own lock, so
+ * that writers of different ranges do not wait for each other (see
+ * rb_sharded_new)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Sharded_ RB_Sharded;
+
+/**
+ * @brief Tree whose versions share their unchanged subtrees, so that taking a
+ * snapshot costs O(1) (see rb_persistent_new)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Persistent_ RB_Persistent;
+
+/**
+ * @brief Immutable version of a persistent tree
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Snapshot_ RB_Snapshot;
+
+/**
+ * @brief Read-only image of a tree mapped from a file (see rb_tree_map)
+ * @note This struct is NOT user specific
+ */
+typedef struct RB_Mapped_ RB_Mapped;
+
+/**
+ * @brief Callback called on each element visited by rb_snapshot_visit
+ * @param data Element being visited
+ * @param ctx User context given to rb_snapshot_visit
+ * @return (int) Non zero to stop the visit
+ */
+typedef int (*RB_DataVisit)(T data, void *ctx);
+
+/**
+ * @brief Position in the in-order traversal of a tree
+ * @param tree Tree being traversed
+ * @param node Current node, or NULL once the traversal is over
+ * @note This struct is NOT user specific
+ * @note A cursor stays valid when other nodes are inserted or deleted, since
+ * neither operation moves or frees any other node
+ */
+typedef struct RB_Cursor_
+{
+    RB_Tree *tree;
+    RB_Node *node;
+} RB_Cursor;
+
+/**
+ * @brief Callback called on each node visited by rb_range
+ * @param node Node being visited
+ * @param ctx User context given to rb_range
+ * @return 0 to continue the visit, any other value to stop it
+ */
+typedef int (*RB_Visit)(RB_Node *node, void *ctx);
+
+/**
+ * @brief Callback called on the data of each node destroyed by
+ * rb_tree_destroy_with
+ * @param data Data of the node being destroyed
+ * @param ctx User context given to rb_tree_destroy_with
+ */
+typedef void (*RB_Destructor)(T data, void *ctx);
+
 // Functions
 
 /**
@@ -85,14 +353,209 @@ typedef struct RB_Tree_
  */
 RB_Tree *rb_tree_new(void);
 
+/**
+ * @brief Allocate a new tree whose nodes are taken from a per-tree pool
+ * @param reserve Number of nodes in the first slab (0 for a default size)
+ * @return (RB_Tree*) Pointer to the new tree
+ * @note Nodes are carved from contiguous slabs and deleted nodes are recycled,
+ * so rb_insert and rb_delete do not call malloc or free in steady state
+ * @note rb_tree_destroy releases the slabs without walking the nodes
+ */
+RB_Tree *rb_tree_new_with_pool(size_t reserve);
+
+/**
+ * @brief Allocate a new tree whose memory comes from the given allocator
+ * @param allocator Allocator to use, or NULL for malloc and free
+ * @return (RB_Tree*) Pointer to the new tree
+ * @note The allocator is copied into the tree, and is also used to allocate
+ * the tree itself
+ */
+RB_Tree *rb_tree_new_with_allocator(const RB_Allocator *allocator);
+
+/**
+ * @brief Allocate a new pooled tree whose memory comes from the given
+ * allocator
+ * @param allocator Allocator to use, or NULL for malloc and free
+ * @param reserve Number of nodes in the first slab (0 for a default size)
+ * @return (RB_Tree*) Pointer to the new tree
+ * @note The allocator is used for the tree itself, its pool and every slab
+ * of nodes, so that a tree can live in an arena or in shared memory
+ */
+RB_Tree *rb_tree_new_with_pool_allocator(const RB_Allocator *allocator,
+                                         size_t reserve);
+
 /**
  * @brief Destroy a tree and free the memory
  * @param tree Tree to destroy
  * @note This function does not free the data stored in the tree
+ * @note This is rb_tree_destroy_with without a destructor
  * @return (void)
  */
 void rb_tree_destroy(RB_Tree *tree);
 
+/**
+ * @brief Destroy a tree, destroying the data of every node first
+ * @param tree Tree to destroy
+ * @param destructor Callback called on the data of each node, may be NULL
+ * @param ctx User context passed to the callback
+ * @return (void)
+ * @note Nodes are visited iteratively in order, without recursion or
+ * allocation
+ * @note Without a destructor, pooled trees release their slabs and trees whose
+ * allocator has no free function return at once, without visiting any node
+ */
+void rb_tree_destroy_with(RB_Tree *tree, RB_Destructor destructor, void *ctx);
+
+/**
+ * @brief Build a tree from a sorted array in O(n)
+ * @param keys Keys sorted in ascending order, duplicates are stored once
+ * @param n Number of keys
+ * @return (RB_Tree*) Pointer to the new tree, or NULL if keys are not sorted
+ * or memory is insufficient
+ * @note The tree is built directly as a balanced, correctly colored tree
+ * without calling rb_insert, and its nodes are laid out contiguously in a
+ * node pool, in key order
+ */
+RB_Tree *rb_tree_build_sorted(const T *keys, size_t n);
+
+/**
+ * @brief Merge a sorted array of keys into an existing tree in O(n + m)
+ * @param tree Tree in which the keys will be inserted
+ * @param keys Keys sorted in ascending order, keys already in the tree and
+ * duplicates are skipped
+ * @param n Number of keys
+ * @return (int) 0 on success, -1 if keys are not sorted or memory is
+ * insufficient, in which case the tree is left unchanged
+ * @note The tree is rebuilt as a balanced tree; existing nodes are relinked,
+ * not moved, so pointers to them stay valid
+ */
+int rb_tree_merge_sorted(RB_Tree *tree, const T *keys, size_t n);
+
+/**
+ * @brief Split a tree in two at a key
+ * @param tree Tree to split, which becomes one of the two parts
+ * @param key Keys smaller than key go to *left, the others to *right
+ * @param left Receives the tree of the keys smaller than key
+ * @param right Receives the tree of the keys greater than or equal to key
+ * @return (int) 0 on success, -1 if an argument is NULL or memory is
+ * insufficient, in which case tree is left unchanged
+ * @note Nodes are relinked, never moved nor reallocated, by O(log n) joins
+ * along the path to key. The larger part stays in tree and the smaller one
+ * gets a new RB_Tree, whose nodes are then pointed at its nil node in
+ * O(min(|left|, |right|))
+ * @note The two parts share the allocator and the node pool of tree, so that
+ * they can be joined again. Trees sharing a pool must not be modified
+ * concurrently
+ */
+int rb_split(RB_Tree *tree, T key, RB_Tree **left, RB_Tree **right);
+
+/**
+ * @brief Join two trees and a pivot key into one tree
+ * @param left Tree whose keys are all smaller than pivot
+ * @param pivot Key inserted between the two trees
+ * @param right Tree whose keys are all greater than pivot
+ * @return (RB_Tree*) The joined tree, which is left or right while the other
+ * one is freed, or NULL if the keys are not in order, the trees cannot share
+ * their memory or memory is insufficient, in which case both trees are left
+ * unchanged
+ * @note Trees can share their memory when they use the same allocator, and
+ * either both have no node pool, or they have the same pool (like the parts
+ * of rb_split), or they have two pools one of which no other tree uses. Two
+ * such pools are merged, which costs their number of slabs plus the room
+ * left in one of them
+ * @note The shorter tree is hung with the pivot from the spine of the taller
+ * one at equal black height, in O(log n). The nodes of the smaller tree are
+ * then pointed at the nil node of the larger one in O(min(|left|, |right|))
+ * @note Only the pivot node is allocated
+ */
+RB_Tree *rb_join(RB_Tree *left, T pivot, RB_Tree *right);
+
+/**
+ * @brief Join two trees into one tree
+ * @param left Tree whose keys are all smaller than the keys of right
+ * @param right Tree whose keys are all greater than the keys of left
+ * @return (RB_Tree*) The joined tree, which is left or right while the other
+ * one is freed, or NULL under the same conditions as rb_join
+ * @note This is rb_join with the smallest node of right as pivot, and
+ * allocates nothing. It undoes rb_split
+ */
+RB_Tree *rb_concat(RB_Tree *left, RB_Tree *right);
+
+/**
+ * @brief Union of two trees: the keys found in either of them
+ * @param a First tree
+ * @param b Second tree
+ * @param threads Most threads to run on, 0 for one per online processor
+ * @return (RB_Tree*) The union, which is a or b while the other one is freed,
+ * or NULL if an argument is NULL, a and b are the same tree or cannot share
+ * their memory (see rb_join), in which case both are left unchanged
+ * @note The root of a splits b and both halves recurse, on other threads for
+ * large subtrees, then are joined back around it: the work is
+ * O(m log(n / m + 1)) for trees of m <= n keys. Trees whose sizes differ by
+ * a factor of 32 or more are combined on one thread by a descent into the
+ * larger tree for each key of the smaller one, which is faster then. The
+ * nodes of the smaller tree are first pointed at the nil node of the larger
+ * one in O(m)
+ * @note Nodes are relinked, never moved nor allocated. Of two nodes of equal
+ * keys, one is freed after the recursion
+ */
+RB_Tree *rb_union(RB_Tree *a, RB_Tree *b, unsigned threads);
+
+/**
+ * @brief Intersection of two trees: the keys found in both of them
+ * @param a First tree
+ * @param b Second tree
+ * @param threads Most threads to run on, 0 for one per online processor
+ * @return (RB_Tree*) The intersection, which is a or b while the other one is
+ * freed, or NULL under the same conditions as rb_union
+ * @note This works like rb_union, the nodes left out being freed in
+ * O(n + m - |result|) after the recursion
+ */
+RB_Tree *rb_intersect(RB_Tree *a, RB_Tree *b, unsigned threads);
+
+/**
+ * @brief Difference of two trees: the keys of a that are not in b
+ * @param a Tree whose keys are kept
+ * @param b Tree whose keys are removed from a
+ * @param threads Most threads to run on, 0 for one per online processor
+ * @return (RB_Tree*) The difference, which is a or b while the other one is
+ * freed, or NULL under the same conditions as rb_union
+ * @note This works like rb_union, the nodes left out being freed in
+ * O(n + m - |result|) after the recursion
+ */
+RB_Tree *rb_difference(RB_Tree *a, RB_Tree *b, unsigned threads);
+
+/**
+ * @brief Get the number of nodes in the tree
+ * @param tree Tree to measure
+ * @return (size_t) Number of nodes, 0 if tree is NULL
+ * @note This function runs in O(1)
+ */
+size_t rb_tree_size(const RB_Tree *tree);
+
+#ifdef RB_STATS
+/**
+ * @brief Read the counters of a tree
+ * @param tree Tree to inspect
+ * @param out Receives the counters, with the size, height and black height
+ * of the tree
+ * @return (int) 0 on success, -1 if tree or out is NULL
+ * @note The counters run in O(1) per event, the height is measured here in
+ * O(n). It requires RB_STATS
+ * @note Lookups update the counters, so that with RB_STATS even concurrent
+ * rb_find calls on one tree must be serialized
+ */
+int rb_tree_stats(const RB_Tree *tree, RB_Stats *out);
+
+/**
+ * @brief Set the counters of a tree back to zero
+ * @param tree Tree whose counters are reset
+ * @return (void)
+ * @note It requires RB_STATS
+ */
+void rb_tree_stats_reset(RB_Tree *tree);
+#endif // RB_STATS
+
 /**
  * @brief Insert a new node in the tree
  * @param tree Tree in which the node will be inserted
@@ -104,17 +567,72 @@ void rb_tree_destroy(RB_Tree *tree);
  */
 RB_Node *rb_insert(RB_Tree *tree, T data);
 
+/**
+ * @brief Find the node of data, or insert one, in a single descent
+ * @param tree Tree in which data will be searched and inserted
+ * @param data Data to find or insert
+ * @param inserted If not NULL, receives 1 if a node was created, 0 if data
+ * was already in the tree or on failure
+ * @return (RB_Node*) The node holding data, or NULL if tree is NULL or memory
+ * is insufficient
+ * @note This is rb_insert telling which case happened, so that rb_find
+ * followed by rb_insert on a miss, which descends twice, is not needed
+ */
+RB_Node *rb_find_or_insert(RB_Tree *tree, T data, int *inserted);
+
+/**
+ * @brief Insert data, or overwrite the data of the node with an equal key,
+ * in a single descent
+ * @param tree Tree in which data will be inserted
+ * @param data Data to store
+ * @param inserted If not NULL, receives 1 if a node was created, 0 if an
+ * existing node was overwritten or on failure
+ * @return (RB_Node*) The node holding data, or NULL if tree is NULL or memory
+ * is insufficient
+ * @note The node stays in place: overwriting is only meaningful when T
+ * carries more than what compCMP compares, and must not change its order
+ */
+RB_Node *rb_upsert(RB_Tree *tree, T data, int *inserted);
+
+/**
+ * @brief Insert a batch of keys in the tree
+ * @param tree Tree in which the keys will be inserted
+ * @param keys Keys to insert, in any order
+ * @param n Number of keys
+ * @param out_nodes If not NULL, receives for each key the node holding it, as
+ * rb_insert would return it (NULL if memory was insufficient)
+ * @return (size_t) Number of nodes created
+ * @note The batch is sorted if needed, then each insertion starts from the
+ * previous insertion point and climbs only as far as needed (finger search),
+ * so nearby keys cost far fewer comparisons than a descent from the root
+ */
+size_t rb_insert_batch(RB_Tree *tree, const T *keys, size_t n,
+                       RB_Node **out_nodes);
+
 /**
  * @brief Delete a node from the tree
  * @param tree Tree from which the node will be deleted
  * @param z Pointer to the node to delete
  * @return (void)
  * @note This function does not free the data stored in the node
- * @note The user is expected to call findNode before calling this function, in
- * order to check if the node exists
+ * @note The user is expected to call rb_find before calling this function, in
+ * order to check if the node exists, or to call rb_erase
+ * @note Only z is freed: other nodes are relinked, not copied, so pointers
+ * returned by rb_insert or rb_find stay valid until their own node is deleted
  */
 void rb_delete(RB_Tree *tree, RB_Node *z);
 
+/**
+ * @brief Delete the node of data from the tree, if there is one
+ * @param tree Tree from which data will be deleted
+ * @param data Data to delete
+ * @return (int) 1 if a node was deleted, 0 if data was not in the tree or
+ * tree is NULL
+ * @note The tree is descended once, by rb_find, then the node is unlinked in
+ * place by rb_delete
+ */
+int rb_erase(RB_Tree *tree, T data);
+
 /**
  * @brief Find a node in the tree
  * @param tree Tree in which the node will be searched
@@ -124,6 +642,579 @@ void rb_delete(RB_Tree *tree, RB_Node *z);
  */
 RB_Node *rb_find(RB_Tree *tree, T data);
 
+/**
+ * @brief Find a batch of keys in the tree
+ * @param tree Tree in which the keys will be searched
+ * @param keys Keys to find
+ * @param n Number of keys
+ * @param out Receives for each key the node holding it, or NULL
+ * @return (size_t) Number of keys found
+ * @note Several descents are interleaved and the next node of each one is
+ * prefetched, so that their cache misses overlap. On trees larger than the
+ * cache this is several times faster than calling rb_find in a loop
+ */
+size_t rb_find_batch(RB_Tree *tree, const T *keys, size_t n, RB_Node **out);
+
+#ifdef RB_ORDER_STATISTICS
+/**
+ * @brief Find the k-th smallest node of the tree
+ * @param tree Tree in which the node will be searched
+ * @param k Rank of the node, starting at 0 for the smallest node
+ * @return (RB_Node*) Pointer to the node, or NULL if k is out of range
+ * @note This function runs in O(log n), it requires RB_ORDER_STATISTICS
+ */
+RB_Node *rb_select(RB_Tree *tree, size_t k);
+
+/**
+ * @brief Count the nodes whose data is smaller than the given data
+ * @param tree Tree in which the nodes will be counted
+ * @param data Data to compare with, it does not need to be in the tree
+ * @return (size_t) Number of nodes smaller than data, which is also the rank
+ * of data if it is in the tree
+ * @note This function runs in O(log n), it requires RB_ORDER_STATISTICS
+ */
+size_t rb_rank(RB_Tree *tree, T data);
+#endif // RB_ORDER_STATISTICS
+
+/**
+ * @brief Find the first node whose data is greater than or equal to data
+ * @param tree Tree in which the node will be searched
+ * @param data Data to compare with
+ * @return (RB_Node*) Pointer to the node, or NULL if every node is smaller
+ */
+RB_Node *rb_lower_bound(RB_Tree *tree, T data);
+
+/**
+ * @brief Find the first node whose data is strictly greater than data
+ * @param tree Tree in which the node will be searched
+ * @param data Data to compare with
+ * @return (RB_Node*) Pointer to the node, or NULL if no node is greater
+ */
+RB_Node *rb_upper_bound(RB_Tree *tree, T data);
+
+/**
+ * @brief Find the last node whose data is smaller than or equal to data
+ * @param tree Tree in which the node will be searched
+ * @param data Data to compare with
+ * @return (RB_Node*) Pointer to the node, or NULL if every node is greater
+ */
+RB_Node *rb_floor(RB_Tree *tree, T data);
+
+/**
+ * @brief Find the first node whose data is greater than or equal to data
+ * @param tree Tree in which the node will be searched
+ * @param data Data to compare with
+ * @return (RB_Node*) Pointer to the node, or NULL if every node is smaller
+ * @note This is the same as rb_lower_bound
+ */
+RB_Node *rb_ceil(RB_Tree *tree, T data);
+
+/**
+ * @brief Visit in order every node whose data is in [lo, hi)
+ * @param tree Tree to visit
+ * @param lo Inclusive lower bound
+ * @param hi Exclusive upper bound
+ * @param visit Callback called on each node, which can stop the visit
+ * @param ctx User context passed to the callback
+ * @return (size_t) Number of nodes passed to the callback
+ * @note This function descends once to lo and then follows the successors, so
+ * it runs in O(log n + k) for k visited nodes
+ * @note The callback must not insert or delete nodes
+ */
+size_t rb_range(RB_Tree *tree, T lo, T hi, RB_Visit visit, void *ctx);
+
+/**
+ * @brief Find the smallest node of the tree
+ * @param tree Tree to search
+ * @return (RB_Node*) Pointer to the smallest node, or NULL if the tree is empty
+ */
+RB_Node *rb_first(RB_Tree *tree);
+
+/**
+ * @brief Find the largest node of the tree
+ * @param tree Tree to search
+ * @return (RB_Node*) Pointer to the largest node, or NULL if the tree is empty
+ */
+RB_Node *rb_last(RB_Tree *tree);
+
+/**
+ * @brief Find the in-order successor of a node
+ * @param tree Tree containing the node
+ * @param node Node to start from
+ * @return (RB_Node*) Pointer to the next node, or NULL if node is the largest
+ * @note This function follows the parent pointers, it does not allocate and
+ * a full traversal is O(1) amortized per node
+ */
+RB_Node *rb_next(RB_Tree *tree, RB_Node *node);
+
+/**
+ * @brief Find the in-order predecessor of a node
+ * @param tree Tree containing the node
+ * @param node Node to start from
+ * @return (RB_Node*) Pointer to the previous node, or NULL if node is the
+ * smallest
+ * @note This function follows the parent pointers, it does not allocate and
+ * a full traversal is O(1) amortized per node
+ */
+RB_Node *rb_prev(RB_Tree *tree, RB_Node *node);
+
+/**
+ * @brief Position a cursor on the smallest node of a tree
+ * @param cursor Cursor to initialize
+ * @param tree Tree to traverse
+ * @return (void)
+ */
+void rb_cursor_first(RB_Cursor *cursor, RB_Tree *tree);
+
+/**
+ * @brief Position a cursor on the largest node of a tree
+ * @param cursor Cursor to initialize
+ * @param tree Tree to traverse
+ * @return (void)
+ */
+void rb_cursor_last(RB_Cursor *cursor, RB_Tree *tree);
+
+/**
+ * @brief Move a cursor to the next node
+ * @param cursor Cursor to move
+ * @return (RB_Node*) The new current node, or NULL at the end of the tree
+ */
+RB_Node *rb_cursor_next(RB_Cursor *cursor);
+
+/**
+ * @brief Move a cursor to the previous node
+ * @param cursor Cursor to move
+ * @return (RB_Node*) The new current node, or NULL at the start of the tree
+ */
+RB_Node *rb_cursor_prev(RB_Cursor *cursor);
+
+/**
+ * @brief Freeze the keys of a tree into a read optimized snapshot
+ * @param tree Tree to freeze
+ * @return (RB_Frozen*) Snapshot of the tree, or NULL on failure
+ * @note The keys are stored in Eytzinger (breadth first) order in a single
+ * array, which is searched without branches while prefetching the levels
+ * ahead, so that a lookup takes a fraction of the cache misses of rb_find
+ * @note The snapshot does not follow later changes of the tree, see
+ * rb_frozen_refresh
+ */
+RB_Frozen *rb_tree_freeze(RB_Tree *tree);
+
+/**
+ * @brief Bring a snapshot up to date with its tree
+ * @param frozen Snapshot to refresh
+ * @param tree Tree the snapshot was taken from
+ * @return (int) 0 on success, -1 on failure (the snapshot is left unchanged)
+ * @note Nothing is done when the tree has not changed since the snapshot was
+ * taken, and the array is reused when the tree did not outgrow it
+ */
+int rb_frozen_refresh(RB_Frozen *frozen, RB_Tree *tree);
+
+/**
+ * @brief Find a key in a snapshot
+ * @param frozen Snapshot in which the key will be searched
+ * @param data Key to find
+ * @return (const T*) Key of the snapshot equal to data, or NULL
+ */
+const T *rb_frozen_find(const RB_Frozen *frozen, T data);
+
+/**
+ * @brief Find the smallest key of a snapshot not less than data
+ * @param frozen Snapshot in which the key will be searched
+ * @param data Key to compare with
+ * @return (const T*) Smallest key >= data, or NULL
+ */
+const T *rb_frozen_lower_bound(const RB_Frozen *frozen, T data);
+
+/**
+ * @brief Number of keys in a snapshot
+ * @param frozen Snapshot
+ * @return (size_t) Number of keys, 0 if frozen is NULL
+ */
+size_t rb_frozen_size(const RB_Frozen *frozen);
+
+/**
+ * @brief Destroy a snapshot
+ * @param frozen Snapshot to destroy
+ * @return (void)
+ */
+void rb_frozen_destroy(RB_Frozen *frozen);
+
+/**
+ * @brief Freeze the keys of a tree into a static B-tree of 16 keys blocks
+ * @param tree Tree to freeze
+ * @return (RB_FrozenBlocks*) Snapshot of the tree, or NULL on failure
+ * @note Each block fills one cache line and is searched at once. With
+ * RB_T_INT the block is compared with vector instructions (AVX-512, AVX2 or
+ * SSE2, chosen from the running processor), otherwise with scalar code
+ * @note The snapshot does not follow later changes of the tree, see
+ * rb_frozen_blocks_refresh
+ */
+RB_FrozenBlocks *rb_tree_freeze_blocks(RB_Tree *tree);
+
+/**
+ * @brief Bring a block snapshot up to date with its tree
+ * @param frozen Snapshot to refresh
+ * @param tree Tree the snapshot was taken from
+ * @return (int) 0 on success, -1 on failure (the snapshot is left unchanged)
+ * @note Nothing is done when the tree has not changed since the snapshot was
+ * taken, and the blocks are reused when the tree did not outgrow them
+ */
+int rb_frozen_blocks_refresh(RB_FrozenBlocks *frozen, RB_Tree *tree);
+
+/**
+ * @brief Find a key in a block snapshot
+ * @param frozen Snapshot in which the key will be searched
+ * @param data Key to find
+ * @return (const T*) Key of the snapshot equal to data, or NULL
+ */
+const T *rb_frozen_blocks_find(const RB_FrozenBlocks *frozen, T data);
+
+/**
+ * @brief Find the smallest key of a block snapshot not less than data
+ * @param frozen Snapshot in which the key will be searched
+ * @param data Key to compare with
+ * @return (const T*) Smallest key >= data, or NULL
+ */
+const T *rb_frozen_blocks_lower_bound(const RB_FrozenBlocks *frozen, T data);
+
+/**
+ * @brief Number of keys in a block snapshot
+ * @param frozen Snapshot
+ * @return (size_t) Number of keys, 0 if frozen is NULL
+ */
+size_t rb_frozen_blocks_size(const RB_FrozenBlocks *frozen);
+
+/**
+ * @brief Instruction set used to search a block snapshot
+ * @param frozen Snapshot
+ * @return (const char*) "avx512", "avx2", "sse2" or "scalar"
+ */
+const char *rb_frozen_blocks_isa(const RB_FrozenBlocks *frozen);
+
+/**
+ * @brief Destroy a block snapshot
+ * @param frozen Snapshot to destroy
+ * @return (void)
+ */
+void rb_frozen_blocks_destroy(RB_FrozenBlocks *frozen);
+
+/**
+ * @brief Create an empty tree shared between threads
+ * @return (RB_Concurrent*) The new tree, or NULL on failure
+ * @note Writers (rb_concurrent_insert, rb_concurrent_delete) serialize on a
+ * mutex. Readers (rb_concurrent_find) take no lock: they retry when a writer
+ * changed the tree during their lookup, and deleted nodes are retired and
+ * only freed once every reader has moved past them (epoch based reclamation)
+ * @note Needs a compiler with the GCC __atomic builtins and POSIX threads
+ */
+RB_Concurrent *rb_concurrent_new(void);
+
+/**
+ * @brief Destroy a concurrent tree
+ * @param tree Tree to destroy
+ * @return (void)
+ * @note No thread may use the tree or one of its readers anymore
+ */
+void rb_concurrent_destroy(RB_Concurrent *tree);
+
+/**
+ * @brief Register a reader with a concurrent tree
+ * @param tree Tree to read
+ * @return (RB_Reader*) The reader, or NULL on failure
+ * @note A reader is used by one thread at a time, typically one per thread
+ */
+RB_Reader *rb_concurrent_reader(RB_Concurrent *tree);
+
+/**
+ * @brief Unregister a reader, which may be handed out again
+ * @param reader Reader to release
+ * @return (void)
+ */
+void rb_concurrent_reader_release(RB_Reader *reader);
+
+/**
+ * @brief Find data in a concurrent tree without taking a lock
+ * @param reader Reader of the calling thread
+ * @param data Data to find
+ * @param out Receives the stored element equal to data, may be NULL
+ * @return (int) 1 if data was found, 0 otherwise
+ */
+int rb_concurrent_find(RB_Reader *reader, T data, T *out);
+
+/**
+ * @brief Insert data in a concurrent tree
+ * @param tree Tree in which data will be inserted
+ * @param data Data to insert
+ * @return (int) 1 if data was inserted, 0 if it was already there, -1 if
+ * tree is NULL or memory runs out
+ */
+int rb_concurrent_insert(RB_Concurrent *tree, T data);
+
+/**
+ * @brief Delete data from a concurrent tree
+ * @param tree Tree from which data will be deleted
+ * @param data Data to delete
+ * @return (int) 1 if data was deleted, 0 if it was not in the tree, -1 if
+ * tree is NULL or memory runs out
+ * @note The node is freed later, once no reader can still be on it
+ */
+int rb_concurrent_delete(RB_Concurrent *tree, T data);
+
+/**
+ * @brief Number of elements of a concurrent tree
+ * @param tree Tree
+ * @return (size_t) Number of elements, 0 if tree is NULL
+ */
+size_t rb_concurrent_size(RB_Concurrent *tree);
+
+/**
+ * @brief Create an empty sharded tree
+ * @param bounds Sorted keys splitting the key space: shard i holds the keys in
+ * [bounds[i - 1], bounds[i]), the first and the last shards being open ended
+ * @param n Number of bounds, giving n + 1 shards
+ * @return (RB_Sharded*) The new tree, or NULL on failure
+ * @note Each shard is a tree with its own node pool and mutex. Operations on
+ * keys of different shards run in parallel, so bounds should split the keys
+ * written into ranges of similar activity
+ */
+RB_Sharded *rb_sharded_new(const T *bounds, size_t n);
+
+/**
+ * @brief Destroy a sharded tree
+ * @param tree Tree to destroy
+ * @return (void)
+ * @note No thread may use the tree anymore
+ */
+void rb_sharded_destroy(RB_Sharded *tree);
+
+/**
+ * @brief Insert data in a sharded tree
+ * @param tree Tree in which data will be inserted
+ * @param data Data to insert
+ * @return (int) 1 if data was inserted, 0 if it was already there, -1 on
+ * failure
+ */
+int rb_sharded_insert(RB_Sharded *tree, T data);
+
+/**
+ * @brief Find data in a sharded tree
+ * @param tree Tree in which data will be searched
+ * @param data Data to find
+ * @param out Receives the stored element equal to data, may be NULL
+ * @return (int) 1 if data was found, 0 otherwise
+ */
+int rb_sharded_find(RB_Sharded *tree, T data, T *out);
+
+/**
+ * @brief Delete data from a sharded tree
+ * @param tree Tree from which data will be deleted
+ * @param data Data to delete
+ * @return (int) 1 if data was deleted, 0 if it was not in the tree
+ */
+int rb_sharded_delete(RB_Sharded *tree, T data);
+
+/**
+ * @brief Number of elements of a sharded tree
+ * @param tree Tree
+ * @return (size_t) Number of elements, 0 if tree is NULL
+ * @note Shards are counted one after the other, so concurrent writes may be
+ * partially counted
+ */
+size_t rb_sharded_size(RB_Sharded *tree);
+
+/**
+ * @brief Visit in order every node of a sharded tree whose data is in
+ * [lo, hi)
+ * @param tree Tree to visit
+ * @param lo Inclusive lower bound
+ * @param hi Exclusive upper bound
+ * @param visit Callback called on each node, which can stop the visit
+ * @param ctx User context passed to the callback
+ * @return (size_t) Number of nodes passed to the callback
+ * @note Only the shards overlapping [lo, hi) are visited, each one under its
+ * lock. The callback must not use the sharded tree
+ */
+size_t rb_sharded_range(RB_Sharded *tree, T lo, T hi, RB_Visit visit,
+                        void *ctx);
+
+/**
+ * @brief Visit in order every node of a sharded tree
+ * @param tree Tree to visit
+ * @param visit Callback called on each node, which can stop the visit
+ * @param ctx User context passed to the callback
+ * @return (size_t) Number of nodes passed to the callback
+ * @note Each shard is visited under its lock. The callback must not use the
+ * sharded tree
+ */
+size_t rb_sharded_visit(RB_Sharded *tree, RB_Visit visit, void *ctx);
+
+/**
+ * @brief Create an empty persistent tree
+ * @return (RB_Persistent*) The new tree, or NULL on failure
+ * @note Nodes have no parent and are reference counted. An update copies
+ * the nodes on its path that a snapshot still shares and changes the others
+ * in place, so that writes cost no copy while no snapshot is alive
+ * @note Writers serialize on a mutex, snapshots are read without lock
+ */
+RB_Persistent *rb_persistent_new(void);
+
+/**
+ * @brief Destroy a persistent tree
+ * @param tree Tree to destroy
+ * @return (void)
+ * @note Snapshots of the tree remain valid until they are released
+ */
+void rb_persistent_destroy(RB_Persistent *tree);
+
+/**
+ * @brief Insert data in a persistent tree
+ * @param tree Tree in which data will be inserted
+ * @param data Data to insert
+ * @return (int) 1 if data was inserted, 0 if it was already there, -1 if
+ * tree is NULL or memory runs out (the tree is left unchanged)
+ */
+int rb_persistent_insert(RB_Persistent *tree, T data);
+
+/**
+ * @brief Delete data from a persistent tree
+ * @param tree Tree from which data will be deleted
+ * @param data Data to delete
+ * @return (int) 1 if data was deleted, 0 if it was not in the tree, -1 if
+ * tree is NULL or memory runs out (the tree holds the same elements)
+ */
+int rb_persistent_delete(RB_Persistent *tree, T data);
+
+/**
+ * @brief Find data in the current version of a persistent tree
+ * @param tree Tree in which data will be searched
+ * @param data Data to find
+ * @param out Receives the stored element equal to data, may be NULL
+ * @return (int) 1 if data was found, 0 otherwise
+ */
+int rb_persistent_find(RB_Persistent *tree, T data, T *out);
+
+/**
+ * @brief Number of elements of the current version of a persistent tree
+ * @param tree Tree
+ * @return (size_t) Number of elements, 0 if tree is NULL
+ */
+size_t rb_persistent_size(RB_Persistent *tree);
+
+/**
+ * @brief Take a snapshot of the current version of a persistent tree
+ * @param tree Tree
+ * @return (RB_Snapshot*) The snapshot, or NULL on failure
+ * @note This takes a reference on the root in O(1). The snapshot never
+ * changes and can be read from any thread until rb_snapshot_release
+ */
+RB_Snapshot *rb_persistent_snapshot(RB_Persistent *tree);
+
+/**
+ * @brief Find data in a snapshot
+ * @param snapshot Snapshot in which data will be searched
+ * @param data Data to find
+ * @param out Receives the stored element equal to data, may be NULL
+ * @return (int) 1 if data was found, 0 otherwise
+ */
+int rb_snapshot_find(const RB_Snapshot *snapshot, T data, T *out);
+
+/**
+ * @brief Number of elements of a snapshot
+ * @param snapshot Snapshot
+ * @return (size_t) Number of elements, 0 if snapshot is NULL
+ */
+size_t rb_snapshot_size(const RB_Snapshot *snapshot);
+
+/**
+ * @brief Visit in order every element of a snapshot
+ * @param snapshot Snapshot to visit
+ * @param visit Callback called on each element, which can stop the visit
+ * @param ctx User context passed to the callback
+ * @return (size_t) Number of elements passed to the callback
+ */
+size_t rb_snapshot_visit(const RB_Snapshot *snapshot, RB_DataVisit visit,
+                         void *ctx);
+
+/**
+ * @brief Release a snapshot, freeing the nodes no other version uses
+ * @param snapshot Snapshot to release
+ * @return (void)
+ */
+void rb_snapshot_release(RB_Snapshot *snapshot);
+
+/**
+ * @brief Write a binary image of the tree to a file descriptor
+ * @param tree Tree to save
+ * @param fd File descriptor open for writing, written from its current
+ * offset
+ * @return (int) 0 on success, -1 on failure, with errno telling why
+ * @note The image is a 32 bytes header followed by the keys in ascending
+ * order, as raw bytes of T in the byte order of the machine: T must not hold
+ * pointers
+ */
+int rb_tree_save(RB_Tree *tree, int fd);
+
+/**
+ * @brief Build a tree from a binary image read from a file descriptor
+ * @param fd File descriptor open for reading, positioned at the start of an
+ * image written by rb_tree_save
+ * @return (RB_Tree*) Pointer to the new tree, or NULL if the image is
+ * invalid, truncated, made for another T or another byte order, or memory is
+ * insufficient
+ * @note The keys are read in chunks into the nodes of a pool and the tree is
+ * built balanced in O(n), without calling rb_insert (see
+ * rb_tree_build_sorted)
+ */
+RB_Tree *rb_tree_load(int fd);
+
+/**
+ * @brief Map a binary image read-only and search it in place
+ * @param fd File descriptor of a regular file holding an image written by
+ * rb_tree_save at offset 0
+ * @return (RB_Mapped*) The mapped image, or NULL if the image is invalid,
+ * truncated, made for another T or another byte order, or mapping fails
+ * @note Opening costs O(1) whatever the number of keys: pages are read by the
+ * system as lookups reach them. The file descriptor may be closed afterwards
+ * @note The order of the keys is trusted, not checked
+ */
+RB_Mapped *rb_tree_map(int fd);
+
+/**
+ * @brief Find data in a mapped image
+ * @param mapped Mapped image in which data will be searched
+ * @param data Data to find
+ * @return (const T*) Pointer to the key equal to data inside the mapping, or
+ * NULL if there is none
+ * @note The binary search is branchless, in O(log n)
+ */
+const T *rb_mapped_find(const RB_Mapped *mapped, T data);
+
+/**
+ * @brief Find the smallest key greater than or equal to data in a mapped
+ * image
+ * @param mapped Mapped image in which data will be searched
+ * @param data Data to compare to
+ * @return (const T*) Pointer to the key inside the mapping, or NULL if every
+ * key is smaller than data
+ */
+const T *rb_mapped_lower_bound(const RB_Mapped *mapped, T data);
+
+/**
+ * @brief Get the number of keys of a mapped image
+ * @param mapped Mapped image to measure
+ * @return (size_t) Number of keys, 0 if mapped is NULL
+ */
+size_t rb_mapped_size(const RB_Mapped *mapped);
+
+/**
+ * @brief Unmap an image
+ * @param mapped Mapped image to release, pointers returned by lookups are no
+ * longer valid afterwards
+ * @return (void)
+ */
+void rb_mapped_destroy(RB_Mapped *mapped);
+
 /**
  * @brief This function writes the tree in the dot format in the given file
  * @param tree Tree to write
@@ -0,0 +1,580 @@
+#ifndef RB_TREE_DEFINE_H
+#define RB_TREE_DEFINE_H
+
+// Standard libraries
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Color of a node
+ * @note This enum is shared with rb_tree.h
+ */
+#ifndef RB_COLOR_DEFINED
+#    define RB_COLOR_DEFINED
+typedef enum
+{
+    BLACK,
+    RED
+} RB_Color;
+#endif // RB_COLOR_DEFINED
+
+/**
+ * @brief Three-way comparison of two scalar values
+ * @param a First value
+ * @param b Second value
+ * @return -1 if a < b, 0 if a == b, 1 if a > b
+ * @note This folds into a single machine comparison, and the descent picks the
+ * child with a conditional move instead of a branch
+ */
+#define RB_SCALAR_CMP(a, b) ((a) == (b) ? 0 : ((a) < (b) ? -1 : 1))
+
+/**
+ * @brief Define a red black tree mapping keys of type K to values of type V
+ * @param name Prefix of the generated types and functions
+ * @param K Type of the keys
+ * @param V Type of the values
+ * @param cmp Three-way comparison of two keys, a function or a macro
+ * returning a negative value if a < b, 0 if a == b and a positive value if
+ * a > b
+ * @note This generates the types name_node and name_tree, and the functions
+ * name_new, name_destroy, name_size, name_find, name_insert,
+ * name_find_or_insert, name_upsert, name_delete, name_erase, name_first,
+ * name_last, name_next and name_prev
+ * @note Every function is static inline and calls cmp directly, so the
+ * comparison is inlined in the descent and the macro can be used for several
+ * types in the same translation unit
+ * @note name_insert returns the existing node if the key is already present,
+ * and leaves its value unchanged. name_find_or_insert(tree, key, value,
+ * &inserted) also tells which case happened, and name_upsert(tree, key,
+ * value, &inserted) overwrites the value, each in a single descent. inserted
+ * may be NULL
+ * @note name_delete relinks nodes instead of copying keys and values, so a
+ * node stays valid until its own key is deleted
+ */
+#define RB_TREE_DEFINE(name, K, V, cmp)                                        \
+    typedef struct name##_node_                                                \
+    {                                                                          \
+        struct name##_node_ *left;                                             \
+        struct name##_node_ *right;                                            \
+        struct name##_node_ *parent;                                           \
+        RB_Color color;                                                        \
+        K key;                                                                 \
+        V value;                                                               \
+    } name##_node;                                                             \
+                                                                               \
+    typedef struct name##_tree_                                                \
+    {                                                                          \
+        name##_node *root;                                                     \
+        name##_node nil;                                                       \
+        size_t size;                                                           \
+    } name##_tree;                                                             \
+                                                                               \
+    static inline name##_tree *name##_new(void)                                \
+    {                                                                          \
+        name##_tree *tree = malloc(sizeof(name##_tree));                       \
+        if (!tree)                                                             \
+        {                                                                      \
+            return NULL;                                                       \
+        }                                                                      \
+                                                                               \
+        memset(&tree->nil, 0, sizeof(tree->nil));                              \
+        tree->nil.left = &tree->nil;                                           \
+        tree->nil.right = &tree->nil;                                          \
+        tree->nil.parent = &tree->nil;                                         \
+        tree->nil.color = BLACK;                                               \
+        tree->root = &tree->nil;                                               \
+        tree->size = 0;                                                        \
+                                                                               \
+        return tree;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_destroy(name##_tree *tree)                       \
+    {                                                                          \
+        if (!tree)                                                             \
+        {                                                                      \
+            return;                                                            \
+        }                                                                      \
+                                                                               \
+        /* Post-order walk along the parent pointers, without recursion */     \
+        name##_node *node = tree->root;                                        \
+        while (node != &tree->nil)                                             \
+        {                                                                      \
+            if (node->left != &tree->nil)                                      \
+            {                                                                  \
+                node = node->left;                                             \
+            }                                                                  \
+            else if (node->right != &tree->nil)                                \
+            {                                                                  \
+                node = node->right;                                            \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                name##_node *parent = node->parent;                            \
+                if (parent)                                                    \
+                {                                                              \
+                    if (parent->left == node)                                  \
+                    {                                                          \
+                        parent->left = &tree->nil;                             \
+                    }                                                          \
+                    else                                                       \
+                    {                                                          \
+                        parent->right = &tree->nil;                            \
+                    }                                                          \
+                }                                                              \
+                free(node);                                                    \
+                node = parent ? parent : &tree->nil;                           \
+            }                                                                  \
+        }                                                                      \
+        free(tree);                                                            \
+    }                                                                          \
+                                                                               \
+    static inline size_t name##_size(const name##_tree *tree)                  \
+    {                                                                          \
+        return tree ? tree->size : 0;                                          \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_find(name##_tree *tree, K key)           \
+    {                                                                          \
+        if (!tree)                                                             \
+        {                                                                      \
+            return NULL;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *current = tree->root;                                     \
+        while (current != &tree->nil)                                          \
+        {                                                                      \
+            int c = cmp(key, current->key);                                    \
+            if (c == 0)                                                        \
+            {                                                                  \
+                return current;                                                \
+            }                                                                  \
+            current = c < 0 ? current->left : current->right;                  \
+        }                                                                      \
+        return NULL;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_rotate_left(name##_tree *tree,                   \
+                                          name##_node *x)                      \
+    {                                                                          \
+        name##_node *y = x->right;                                             \
+                                                                               \
+        x->right = y->left;                                                    \
+        if (y->left != &tree->nil)                                             \
+        {                                                                      \
+            y->left->parent = x;                                               \
+        }                                                                      \
+        y->parent = x->parent;                                                 \
+        if (!x->parent)                                                        \
+        {                                                                      \
+            tree->root = y;                                                    \
+        }                                                                      \
+        else if (x == x->parent->left)                                         \
+        {                                                                      \
+            x->parent->left = y;                                               \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            x->parent->right = y;                                              \
+        }                                                                      \
+        y->left = x;                                                           \
+        x->parent = y;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void name##_rotate_right(name##_tree *tree,                  \
+                                           name##_node *x)                     \
+    {                                                                          \
+        name##_node *y = x->left;                                              \
+                                                                               \
+        x->left = y->right;                                                    \
+        if (y->right != &tree->nil)                                            \
+        {                                                                      \
+            y->right->parent = x;                                              \
+        }                                                                      \
+        y->parent = x->parent;                                                 \
+        if (!x->parent)                                                        \
+        {                                                                      \
+            tree->root = y;                                                    \
+        }                                                                      \
+        else if (x == x->parent->right)                                        \
+        {                                                                      \
+            x->parent->right = y;                                              \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            x->parent->left = y;                                               \
+        }                                                                      \
+        y->right = x;                                                          \
+        x->parent = y;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline void name##_insert_fixup(name##_tree *tree,                  \
+                                           name##_node *x)                     \
+    {                                                                          \
+        while (x != tree->root && x->parent->color == RED)                     \
+        {                                                                      \
+            name##_node *g = x->parent->parent;                                \
+            if (x->parent == g->left)                                          \
+            {                                                                  \
+                name##_node *y = g->right;                                     \
+                if (y->color == RED)                                           \
+                {                                                              \
+                    x->parent->color = BLACK;                                  \
+                    y->color = BLACK;                                          \
+                    g->color = RED;                                            \
+                    x = g;                                                     \
+                }                                                              \
+                else                                                           \
+                {                                                              \
+                    if (x == x->parent->right)                                 \
+                    {                                                          \
+                        x = x->parent;                                         \
+                        name##_rotate_left(tree, x);                           \
+                    }                                                          \
+                    x->parent->color = BLACK;                                  \
+                    g->color = RED;                                            \
+                    name##_rotate_right(tree, g);                              \
+                }                                                              \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                name##_node *y = g->left;                                      \
+                if (y->color == RED)                                           \
+                {                                                              \
+                    x->parent->color = BLACK;                                  \
+                    y->color = BLACK;                                          \
+                    g->color = RED;                                            \
+                    x = g;                                                     \
+                }                                                              \
+                else                                                           \
+                {                                                              \
+                    if (x == x->parent->left)                                  \
+                    {                                                          \
+                        x = x->parent;                                         \
+                        name##_rotate_right(tree, x);                          \
+                    }                                                          \
+                    x->parent->color = BLACK;                                  \
+                    g->color = RED;                                            \
+                    name##_rotate_left(tree, g);                               \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+        tree->root->color = BLACK;                                             \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_find_or_insert(                          \
+        name##_tree *tree, K key, V value, int *inserted)                      \
+    {                                                                          \
+        if (inserted)                                                          \
+        {                                                                      \
+            *inserted = 0;                                                     \
+        }                                                                      \
+        if (!tree)                                                             \
+        {                                                                      \
+            return NULL;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *current = tree->root;                                     \
+        name##_node *parent = NULL;                                            \
+        int c = 0;                                                             \
+        while (current != &tree->nil)                                          \
+        {                                                                      \
+            c = cmp(key, current->key);                                        \
+            if (c == 0)                                                        \
+            {                                                                  \
+                return current;                                                \
+            }                                                                  \
+            parent = current;                                                  \
+            current = c < 0 ? current->left : current->right;                  \
+        }                                                                      \
+                                                                               \
+        name##_node *x = malloc(sizeof(*x));                                   \
+        if (!x)                                                                \
+        {                                                                      \
+            fprintf(stderr, "insufficient memory (" #name "_insert)\n");       \
+            return NULL;                                                       \
+        }                                                                      \
+        x->key = key;                                                          \
+        x->value = value;                                                      \
+        x->parent = parent;                                                    \
+        x->left = &tree->nil;                                                  \
+        x->right = &tree->nil;                                                 \
+        x->color = RED;                                                        \
+                                                                               \
+        if (!parent)                                                           \
+        {                                                                      \
+            tree->root = x;                                                    \
+        }                                                                      \
+        else if (c < 0)                                                        \
+        {                                                                      \
+            parent->left = x;                                                  \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            parent->right = x;                                                 \
+        }                                                                      \
+        tree->size++;                                                          \
+                                                                               \
+        name##_insert_fixup(tree, x);                                          \
+        if (inserted)                                                          \
+        {                                                                      \
+            *inserted = 1;                                                     \
+        }                                                                      \
+        return x;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_insert(name##_tree *tree, K key,         \
+                                             V value)                          \
+    {                                                                          \
+        return name##_find_or_insert(tree, key, value, NULL);                  \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_upsert(name##_tree *tree, K key,         \
+                                             V value, int *inserted)           \
+    {                                                                          \
+        int created;                                                           \
+        name##_node *node =                                                    \
+            name##_find_or_insert(tree, key, value, &created);                 \
+        if (node && !created)                                                  \
+        {                                                                      \
+            node->value = value;                                               \
+        }                                                                      \
+        if (inserted)                                                          \
+        {                                                                      \
+            *inserted = created;                                               \
+        }                                                                      \
+        return node;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_transplant(name##_tree *tree, name##_node *u,    \
+                                         name##_node *v)                       \
+    {                                                                          \
+        if (!u->parent)                                                        \
+        {                                                                      \
+            tree->root = v;                                                    \
+        }                                                                      \
+        else if (u == u->parent->left)                                         \
+        {                                                                      \
+            u->parent->left = v;                                               \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            u->parent->right = v;                                              \
+        }                                                                      \
+        v->parent = u->parent;                                                 \
+    }                                                                          \
+                                                                               \
+    static inline void name##_delete_fixup(name##_tree *tree,                  \
+                                           name##_node *x)                     \
+    {                                                                          \
+        while (x != tree->root && x->color == BLACK)                           \
+        {                                                                      \
+            if (x == x->parent->left)                                          \
+            {                                                                  \
+                name##_node *w = x->parent->right;                             \
+                if (w->color == RED)                                           \
+                {                                                              \
+                    w->color = BLACK;                                          \
+                    x->parent->color = RED;                                    \
+                    name##_rotate_left(tree, x->parent);                       \
+                    w = x->parent->right;                                      \
+                }                                                              \
+                if (w->left->color == BLACK && w->right->color == BLACK)       \
+                {                                                              \
+                    w->color = RED;                                            \
+                    x = x->parent;                                             \
+                }                                                              \
+                else                                                           \
+                {                                                              \
+                    if (w->right->color == BLACK)                              \
+                    {                                                          \
+                        w->left->color = BLACK;                                \
+                        w->color = RED;                                        \
+                        name##_rotate_right(tree, w);                          \
+                        w = x->parent->right;                                  \
+                    }                                                          \
+                    w->color = x->parent->color;                               \
+                    x->parent->color = BLACK;                                  \
+                    w->right->color = BLACK;                                   \
+                    name##_rotate_left(tree, x->parent);                       \
+                    x = tree->root;                                            \
+                }                                                              \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                name##_node *w = x->parent->left;                              \
+                if (w->color == RED)                                           \
+                {                                                              \
+                    w->color = BLACK;                                          \
+                    x->parent->color = RED;                                    \
+                    name##_rotate_right(tree, x->parent);                      \
+                    w = x->parent->left;                                       \
+                }                                                              \
+                if (w->right->color == BLACK && w->left->color == BLACK)       \
+                {                                                              \
+                    w->color = RED;                                            \
+                    x = x->parent;                                             \
+                }                                                              \
+                else                                                           \
+                {                                                              \
+                    if (w->left->color == BLACK)                               \
+                    {                                                          \
+                        w->right->color = BLACK;                               \
+                        w->color = RED;                                        \
+                        name##_rotate_left(tree, w);                           \
+                        w = x->parent->left;                                   \
+                    }                                                          \
+                    w->color = x->parent->color;                               \
+                    x->parent->color = BLACK;                                  \
+                    w->left->color = BLACK;                                    \
+                    name##_rotate_right(tree, x->parent);                      \
+                    x = tree->root;                                            \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+        x->color = BLACK;                                                      \
+    }                                                                          \
+                                                                               \
+    /* Unlinks z by relinking its successor in its place, so that no key or    \
+     * value is copied and pointers to other nodes stay valid */               \
+    static inline void name##_delete(name##_tree *tree, name##_node *z)        \
+    {                                                                          \
+        if (!tree || !z || z == &tree->nil)                                    \
+        {                                                                      \
+            return;                                                            \
+        }                                                                      \
+                                                                               \
+        name##_node *x;                                                        \
+        name##_node *y = z;                                                    \
+        RB_Color removed_color = y->color;                                     \
+                                                                               \
+        if (z->left == &tree->nil)                                             \
+        {                                                                      \
+            x = z->right;                                                      \
+            name##_transplant(tree, z, z->right);                              \
+        }                                                                      \
+        else if (z->right == &tree->nil)                                       \
+        {                                                                      \
+            x = z->left;                                                       \
+            name##_transplant(tree, z, z->left);                               \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            y = z->right;                                                      \
+            while (y->left != &tree->nil)                                      \
+            {                                                                  \
+                y = y->left;                                                   \
+            }                                                                  \
+            removed_color = y->color;                                          \
+            x = y->right;                                                      \
+            if (y->parent == z)                                                \
+            {                                                                  \
+                x->parent = y;                                                 \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                name##_transplant(tree, y, y->right);                          \
+                y->right = z->right;                                           \
+                y->right->parent = y;                                          \
+            }                                                                  \
+            name##_transplant(tree, z, y);                                     \
+            y->left = z->left;                                                 \
+            y->left->parent = y;                                               \
+            y->color = z->color;                                               \
+        }                                                                      \
+                                                                               \
+        if (removed_color == BLACK)                                            \
+        {                                                                      \
+            name##_delete_fixup(tree, x);                                      \
+        }                                                                      \
+        tree->size--;                                                          \
+        free(z);                                                               \
+    }                                                                          \
+                                                                               \
+    static inline int name##_erase(name##_tree *tree, K key)                   \
+    {                                                                          \
+        name##_node *node = name##_find(tree, key);                            \
+        if (!node)                                                             \
+        {                                                                      \
+            return 0;                                                          \
+        }                                                                      \
+        name##_delete(tree, node);                                             \
+        return 1;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_first(name##_tree *tree)                 \
+    {                                                                          \
+        if (!tree || tree->root == &tree->nil)                                 \
+        {                                                                      \
+            return NULL;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *node = tree->root;                                        \
+        while (node->left != &tree->nil)                                       \
+        {                                                                      \
+            node = node->left;                                                 \
+        }                                                                      \
+        return node;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_last(name##_tree *tree)                  \
+    {                                                                          \
+        if (!tree || tree->root == &tree->nil)                                 \
+        {                                                                      \
+            return NULL;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *node = tree->root;                                        \
+        while (node->right != &tree->nil)                                      \
+        {                                                                      \
+            node = node->right;                                                \
+        }                                                                      \
+        return node;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_next(name##_tree *tree,                  \
+                                           name##_node *node)                  \
+    {                                                                          \
+        if (node->right != &tree->nil)                                         \
+        {                                                                      \
+            node = node->right;                                                \
+            while (node->left != &tree->nil)                                   \
+            {                                                                  \
+                node = node->left;                                             \
+            }                                                                  \
+            return node;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *parent = node->parent;                                    \
+        while (parent && node == parent->right)                                \
+        {                                                                      \
+            node = parent;                                                     \
+            parent = parent->parent;                                           \
+        }                                                                      \
+        return parent;                                                         \
+    }                                                                          \
+                                                                               \
+    static inline name##_node *name##_prev(name##_tree *tree,                  \
+                                           name##_node *node)                  \
+    {                                                                          \
+        if (node->left != &tree->nil)                                          \
+        {                                                                      \
+            node = node->left;                                                 \
+            while (node->right != &tree->nil)                                  \
+            {                                                                  \
+                node = node->right;                                            \
+            }                                                                  \
+            return node;                                                       \
+        }                                                                      \
+                                                                               \
+        name##_node *parent = node->parent;                                    \
+        while (parent && node == parent->left)                                 \
+        {                                                                      \
+            node = parent;                                                     \
+            parent = parent->parent;                                           \
+        }                                                                      \
+        return parent;                                                         \
+    }
+
+#endif // RB_TREE_DEFINE_H
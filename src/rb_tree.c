@@ -1,16 +1,16 @@
-#include "../rb_tree.h"
+#include "rb_tree_internal.h"
 
 static void generateDot(RB_Tree *tree, RB_Node *node, FILE *fp)
 {
     if (node == &tree->nil)
         return;
 
-    if (node->parent != NULL)
+    if (rb_parent(node) != NULL)
     {
-        fprintf(fp, "  \"%d\" -> \"%d\";\n", node->parent->data, node->data);
+        fprintf(fp, "  \"%d\" -> \"%d\";\n", rb_parent(node)->data, node->data);
     }
 
-    if (node->color == RED)
+    if (rb_color(node) == RED)
     {
         fprintf(fp, "  \"%d\" [color=red];\n", node->data);
     }
@@ -35,3 +35,57 @@ void rb_todot(RB_Tree *tree, const char *filename)
     fprintf(fp, "}\n");
     fclose(fp);
 }
+
+size_t rb_tree_size(const RB_Tree *tree)
+{
+    return tree ? tree->size : 0;
+}
+
+#ifdef RB_STATS
+void rb_stat_descent(RB_Stats *stats, size_t depth)
+{
+    stats->descents++;
+    stats->comparisons += depth;
+    stats->depths[depth < RB_STATS_DEPTHS ? depth : RB_STATS_DEPTHS - 1]++;
+}
+
+static size_t rb_height(const RB_Tree *tree, const RB_Node *node)
+{
+    if (node == &tree->nil)
+    {
+        return 0;
+    }
+
+    size_t left = rb_height(tree, node->left);
+    size_t right = rb_height(tree, node->right);
+    return 1 + (left > right ? left : right);
+}
+
+int rb_tree_stats(const RB_Tree *tree, RB_Stats *out)
+{
+    if (!tree || !out)
+    {
+        return -1;
+    }
+
+    *out = tree->stats;
+    out->size = tree->size;
+    out->height = rb_height(tree, tree->root);
+    out->black_height = 0;
+    for (const RB_Node *node = tree->root; node != &tree->nil;
+         node = node->left)
+    {
+        out->black_height += rb_color(node) == BLACK;
+    }
+    return 0;
+}
+
+void rb_tree_stats_reset(RB_Tree *tree)
+{
+    if (!tree)
+    {
+        return;
+    }
+    tree->stats = (RB_Stats){ 0 };
+}
+#endif // RB_STATS
@@ -0,0 +1,30 @@
+#include "rb_tree_internal.h"
+
+static void *rb_default_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void rb_default_free(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+const RB_Allocator rb_default_allocator = { rb_default_alloc, rb_default_free,
+                                            NULL };
+
+void *rb_alloc(const RB_Allocator *allocator, size_t size)
+{
+    return allocator->alloc(allocator->ctx, size);
+}
+
+void rb_free(const RB_Allocator *allocator, void *ptr, size_t size)
+{
+    if (allocator->free)
+    {
+        allocator->free(allocator->ctx, ptr, size);
+    }
+}
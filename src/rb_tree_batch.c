@@ -0,0 +1,175 @@
+#include "rb_tree_internal.h"
+
+typedef struct
+{
+    T key;
+    size_t index;
+} RB_BatchEntry;
+
+static int rb_batch_entry_cmp(const void *a, const void *b)
+{
+    const RB_BatchEntry *x = a;
+    const RB_BatchEntry *y = b;
+    int cmp = compCMP(x->key, y->key);
+    if (cmp != 0)
+    {
+        return cmp;
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/* Climb from the previous insertion point to the lowest ancestor whose subtree
+ * covers data, knowing that data is not smaller than finger->data. Going up
+ * from a right child needs no comparison: the subtree of the parent has the
+ * same upper bound */
+static RB_Node *rb_finger_climb(RB_Node *finger, T data)
+{
+    RB_Node *current = finger;
+    while (rb_parent(current))
+    {
+        RB_Node *parent = rb_parent(current);
+        if (current == parent->left && compCMP(data, parent->data) < 0)
+        {
+            break;
+        }
+        current = parent;
+    }
+    return current;
+}
+
+static size_t rb_insert_sorted(RB_Tree *tree, const RB_BatchEntry *entries,
+                               const T *keys, size_t n, RB_Node **out_nodes)
+{
+    RB_Node *finger = NULL;
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        T key = entries ? entries[i].key : keys[i];
+        RB_Node *start = finger ? rb_finger_climb(finger, key) : tree->root;
+
+        int inserted;
+        RB_Node *node = rb_insert_from(tree, start, key, &inserted);
+        count += inserted;
+        if (node)
+        {
+            finger = node;
+        }
+        if (out_nodes)
+        {
+            out_nodes[entries ? entries[i].index : i] = node;
+        }
+    }
+    return count;
+}
+
+size_t rb_insert_batch(RB_Tree *tree, const T *keys, size_t n,
+                       RB_Node **out_nodes)
+{
+    if (!tree || !keys)
+    {
+        return 0;
+    }
+
+    size_t sorted = 1;
+    for (size_t i = 1; i < n && sorted; i++)
+    {
+        sorted = compCMP(keys[i - 1], keys[i]) <= 0;
+    }
+    if (sorted)
+    {
+        return rb_insert_sorted(tree, NULL, keys, n, out_nodes);
+    }
+
+    // Sort a copy that remembers where each key came from
+    RB_BatchEntry *entries = malloc(n * sizeof(RB_BatchEntry));
+    if (!entries)
+    {
+        fprintf(stderr, "insufficient memory (rb_insert_batch)\n");
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        entries[i].key = keys[i];
+        entries[i].index = i;
+    }
+    qsort(entries, n, sizeof(RB_BatchEntry), rb_batch_entry_cmp);
+
+    size_t count = rb_insert_sorted(tree, entries, keys, n, out_nodes);
+    free(entries);
+    return count;
+}
+
+/* One descent in flight in rb_find_batch */
+typedef struct
+{
+    RB_Node *node;
+    size_t index;
+} RB_Lane;
+
+size_t rb_find_batch(RB_Tree *tree, const T *keys, size_t n, RB_Node **out)
+{
+    RB_Lane lanes[RB_FIND_BATCH_LANES];
+    size_t active = 0;
+    size_t next = 0;
+    size_t found = 0;
+
+    if (!tree || !keys || !out)
+    {
+        return 0;
+    }
+
+    while (active < RB_FIND_BATCH_LANES && next < n)
+    {
+        lanes[active].node = tree->root;
+        lanes[active].index = next++;
+        active++;
+    }
+
+    // Advance every descent by one level per round and prefetch the node it
+    // needs next, so that the cache misses of the lanes overlap. A finished
+    // lane takes the next key at once
+    while (active > 0)
+    {
+        for (size_t i = 0; i < active;)
+        {
+            RB_Lane *lane = &lanes[i];
+            RB_Node *node = lane->node;
+            int done = node == &tree->nil;
+
+            if (!done)
+            {
+                int cmp = compCMP(keys[lane->index], node->data);
+                if (cmp == 0)
+                {
+                    done = 1;
+                    found++;
+                }
+                else
+                {
+                    lane->node = cmp < 0 ? node->left : node->right;
+                    RB_PREFETCH(lane->node);
+                }
+            }
+
+            if (!done)
+            {
+                i++;
+                continue;
+            }
+
+            out[lane->index] = node == &tree->nil ? NULL : node;
+            if (next < n)
+            {
+                lane->node = tree->root;
+                lane->index = next++;
+                i++;
+            }
+            else
+            {
+                lanes[i] = lanes[--active];
+            }
+        }
+    }
+    return found;
+}
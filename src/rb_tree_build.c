@@ -0,0 +1,228 @@
+#include "rb_tree_internal.h"
+
+typedef struct
+{
+    RB_Tree *tree;
+    RB_Node *head;
+    size_t red_depth;
+} RB_Builder;
+
+/* Build a size-balanced subtree from the next count nodes of the chain. Every
+ * missing child is then at depth red_depth or red_depth + 1, so coloring the
+ * nodes at red_depth red and the others black gives equal black heights */
+static RB_Node *rb_build(RB_Builder *builder, size_t count, size_t depth)
+{
+    RB_Tree *tree = builder->tree;
+
+    if (count == 0)
+    {
+        return &tree->nil;
+    }
+
+    size_t left_count = count / 2;
+    RB_Node *left = rb_build(builder, left_count, depth + 1);
+
+    RB_Node *node = builder->head;
+    builder->head = node->right;
+
+    rb_set_color(node, depth == builder->red_depth ? RED : BLACK);
+    node->left = left;
+    if (left != &tree->nil)
+    {
+        rb_set_parent(left, node);
+    }
+
+    RB_Node *right = rb_build(builder, count - left_count - 1, depth + 1);
+    node->right = right;
+    if (right != &tree->nil)
+    {
+        rb_set_parent(right, node);
+    }
+#ifdef RB_ORDER_STATISTICS
+    node->size = count;
+#endif // RB_ORDER_STATISTICS
+
+    return node;
+}
+
+void rb_build_from_chain(RB_Tree *tree, RB_Node *head, size_t count)
+{
+    RB_Builder builder = { tree, head, (size_t)-1 };
+
+    // The root alone stays black
+    if (count > 1)
+    {
+        builder.red_depth = 0;
+        while (count >> (builder.red_depth + 1))
+        {
+            builder.red_depth++;
+        }
+    }
+
+    tree->root = rb_build(&builder, count, 0);
+    if (tree->root != &tree->nil)
+    {
+        rb_set_parent(tree->root, NULL);
+    }
+    tree->size = count;
+    tree->generation++;
+}
+
+RB_Node *rb_flatten(RB_Tree *tree)
+{
+    RB_Node head;
+    RB_Node *tail = &head;
+
+    RB_Node *node = tree->root;
+    while (node != &tree->nil)
+    {
+        RB_Node *left = node->left;
+        if (left != &tree->nil)
+        {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        }
+        else
+        {
+            tail->right = node;
+            tail = node;
+            node = node->right;
+        }
+    }
+    tail->right = NULL;
+
+    tree->root = &tree->nil;
+    return head.right;
+}
+
+static int rb_is_sorted(const T *keys, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (compCMP(keys[i - 1], keys[i]) > 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+RB_Tree *rb_tree_build_sorted(const T *keys, size_t n)
+{
+    if ((!keys && n) || !rb_is_sorted(keys, n))
+    {
+        return NULL;
+    }
+
+    RB_Tree *tree = rb_tree_new_with_pool(n);
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    // Nodes come out of the first slab in order, so they are contiguous
+    RB_Node head;
+    RB_Node *tail = &head;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i > 0 && compCMP(keys[i - 1], keys[i]) == 0)
+        {
+            continue;
+        }
+
+        RB_Node *node = rb_node_alloc(tree);
+        node->data = keys[i];
+        tail->right = node;
+        tail = node;
+        count++;
+    }
+    tail->right = NULL;
+
+    rb_build_from_chain(tree, head.right, count);
+    return tree;
+}
+
+int rb_tree_merge_sorted(RB_Tree *tree, const T *keys, size_t n)
+{
+    if (!tree || (!keys && n) || !rb_is_sorted(keys, n))
+    {
+        return -1;
+    }
+
+    // Allocate every node up front so that a failure leaves the tree intact
+    RB_Node *spare = NULL;
+    for (size_t i = 0; i < n; i++)
+    {
+        RB_Node *node = rb_node_alloc(tree);
+        if (!node)
+        {
+            while (spare)
+            {
+                RB_Node *next = spare->right;
+                rb_node_free(tree, spare);
+                spare = next;
+            }
+            fprintf(stderr, "insufficient memory (rb_tree_merge_sorted)\n");
+            return -1;
+        }
+        node->right = spare;
+        spare = node;
+    }
+
+    // Merge the existing chain with the keys, skipping duplicates
+    RB_Node *existing = rb_flatten(tree);
+    RB_Node head;
+    RB_Node *tail = &head;
+    size_t count = 0;
+    size_t i = 0;
+    while (existing || i < n)
+    {
+        int cmp = 1;
+        if (existing && i < n)
+        {
+            cmp = compCMP(existing->data, keys[i]);
+        }
+        else if (existing)
+        {
+            cmp = -1;
+        }
+
+        RB_Node *node;
+        if (cmp <= 0)
+        {
+            node = existing;
+            existing = existing->right;
+            if (cmp == 0)
+            {
+                i++;
+            }
+        }
+        else
+        {
+            if (count > 0 && compCMP(tail->data, keys[i]) == 0)
+            {
+                i++;
+                continue;
+            }
+            node = spare;
+            spare = spare->right;
+            node->data = keys[i++];
+        }
+        tail->right = node;
+        tail = node;
+        count++;
+    }
+    tail->right = NULL;
+
+    while (spare)
+    {
+        RB_Node *next = spare->right;
+        rb_node_free(tree, spare);
+        spare = next;
+    }
+
+    rb_build_from_chain(tree, head.right, count);
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include <sched.h>
+
+#include "rb_tree_internal.h"
+
+// Reclamation
+
+/* Free the retired nodes no reader can reach anymore. A node retired at epoch
+ * e was unlinked before the global epoch moved past e, so a reader that
+ * started at a later epoch never saw it */
+static void rb_reclaim(RB_Concurrent *tree)
+{
+    unsigned long oldest = __atomic_load_n(&tree->epoch, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (RB_Reader *reader = tree->readers; reader; reader = reader->next)
+    {
+        unsigned long epoch =
+            __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+
+    // Nodes are retired in epoch order
+    size_t count = 0;
+    while (count < tree->retired_count
+           && tree->retired[count].epoch < oldest)
+    {
+        rb_node_free(tree->tree, tree->retired[count].node);
+        count++;
+    }
+    tree->retired_count -= count;
+    for (size_t i = 0; i < tree->retired_count; i++)
+    {
+        tree->retired[i] = tree->retired[i + count];
+    }
+}
+
+/* Make room for one more retired node */
+static int rb_retire_reserve(RB_Concurrent *tree)
+{
+    if (tree->retired_count < tree->retired_capacity)
+    {
+        return 0;
+    }
+
+    size_t capacity = tree->retired_capacity ? 2 * tree->retired_capacity
+                                             : RB_RETIRE_BATCH;
+    RB_Retired *retired =
+        rb_alloc(&tree->tree->allocator, capacity * sizeof(RB_Retired));
+    if (!retired)
+    {
+        fprintf(stderr, "insufficient memory (rb_concurrent_delete)\n");
+        return -1;
+    }
+    for (size_t i = 0; i < tree->retired_count; i++)
+    {
+        retired[i] = tree->retired[i];
+    }
+    if (tree->retired)
+    {
+        rb_free(&tree->tree->allocator, tree->retired,
+                tree->retired_capacity * sizeof(RB_Retired));
+    }
+    tree->retired = retired;
+    tree->retired_capacity = capacity;
+    return 0;
+}
+
+/* Tag an unlinked node with the current epoch and move the epoch on */
+static void rb_retire(RB_Concurrent *tree, RB_Node *node)
+{
+    tree->retired[tree->retired_count].node = node;
+    tree->retired[tree->retired_count].epoch = tree->epoch;
+    tree->retired_count++;
+    __atomic_store_n(&tree->epoch, tree->epoch + 1, __ATOMIC_RELEASE);
+}
+
+// Writers
+
+/* Make the sequence odd for the time of a change, so that readers retry */
+static void rb_write_begin(RB_Concurrent *tree)
+{
+    pthread_mutex_lock(&tree->lock);
+    __atomic_store_n(&tree->sequence, tree->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void rb_write_end(RB_Concurrent *tree)
+{
+    __atomic_store_n(&tree->sequence, tree->sequence + 1, __ATOMIC_RELEASE);
+    if (tree->retired_count >= RB_RETIRE_BATCH)
+    {
+        rb_reclaim(tree);
+    }
+    pthread_mutex_unlock(&tree->lock);
+}
+
+RB_Concurrent *rb_concurrent_new(void)
+{
+    RB_Tree *inner = rb_tree_new_with_pool(0);
+    if (!inner)
+    {
+        return NULL;
+    }
+
+    RB_Concurrent *tree = rb_alloc(&inner->allocator, sizeof(RB_Concurrent));
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_concurrent_new)\n");
+        rb_tree_destroy(inner);
+        return NULL;
+    }
+    if (pthread_mutex_init(&tree->lock, NULL) != 0)
+    {
+        rb_free(&inner->allocator, tree, sizeof(RB_Concurrent));
+        rb_tree_destroy(inner);
+        return NULL;
+    }
+
+    tree->tree = inner;
+    tree->sequence = 0;
+    tree->epoch = 1;
+    tree->readers = NULL;
+    tree->retired = NULL;
+    tree->retired_count = 0;
+    tree->retired_capacity = 0;
+    return tree;
+}
+
+void rb_concurrent_destroy(RB_Concurrent *tree)
+{
+    if (!tree)
+    {
+        return;
+    }
+
+    RB_Tree *inner = tree->tree;
+    RB_Reader *reader = tree->readers;
+    while (reader)
+    {
+        RB_Reader *next = reader->next;
+        rb_free(&inner->allocator, reader, sizeof(RB_Reader));
+        reader = next;
+    }
+    if (tree->retired)
+    {
+        rb_free(&inner->allocator, tree->retired,
+                tree->retired_capacity * sizeof(RB_Retired));
+    }
+    pthread_mutex_destroy(&tree->lock);
+    rb_free(&inner->allocator, tree, sizeof(RB_Concurrent));
+
+    // Retired nodes belong to the pool and go with it
+    rb_tree_destroy(inner);
+}
+
+int rb_concurrent_insert(RB_Concurrent *tree, T data)
+{
+    if (!tree)
+    {
+        return -1;
+    }
+
+    int inserted;
+    rb_write_begin(tree);
+    RB_Node *node = rb_insert_from(tree->tree, tree->tree->root, data,
+                                   &inserted);
+    rb_write_end(tree);
+    return node ? inserted : -1;
+}
+
+int rb_concurrent_delete(RB_Concurrent *tree, T data)
+{
+    if (!tree)
+    {
+        return -1;
+    }
+
+    int result = 0;
+    rb_write_begin(tree);
+    RB_Node *node = rb_find(tree->tree, data);
+    if (node)
+    {
+        result = -1;
+        if (rb_retire_reserve(tree) == 0)
+        {
+            rb_unlink(tree->tree, node);
+            rb_retire(tree, node);
+            result = 1;
+        }
+    }
+    rb_write_end(tree);
+    return result;
+}
+
+size_t rb_concurrent_size(RB_Concurrent *tree)
+{
+    if (!tree)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tree->lock);
+    size_t size = tree->tree->size;
+    pthread_mutex_unlock(&tree->lock);
+    return size;
+}
+
+// Readers
+
+RB_Reader *rb_concurrent_reader(RB_Concurrent *tree)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&tree->lock);
+    RB_Reader *reader = tree->readers;
+    while (reader && reader->in_use)
+    {
+        reader = reader->next;
+    }
+    if (!reader)
+    {
+        reader = rb_alloc(&tree->tree->allocator, sizeof(RB_Reader));
+        if (reader)
+        {
+            reader->owner = tree;
+            reader->epoch = 0;
+            reader->next = tree->readers;
+            tree->readers = reader;
+        }
+        else
+        {
+            fprintf(stderr, "insufficient memory (rb_concurrent_reader)\n");
+        }
+    }
+    if (reader)
+    {
+        reader->in_use = 1;
+    }
+    pthread_mutex_unlock(&tree->lock);
+    return reader;
+}
+
+void rb_concurrent_reader_release(RB_Reader *reader)
+{
+    if (!reader)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&reader->owner->lock);
+    reader->in_use = 0;
+    pthread_mutex_unlock(&reader->owner->lock);
+}
+
+int rb_concurrent_find(RB_Reader *reader, T data, T *out)
+{
+    if (!reader)
+    {
+        return 0;
+    }
+
+    RB_Concurrent *tree = reader->owner;
+    RB_Node *nil = &tree->tree->nil;
+
+    // Announce the epoch before looking at any node
+    unsigned long epoch = __atomic_load_n(&tree->epoch, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (unsigned spins = 0;; spins++)
+    {
+        // A writer is at work. Past a few tries, it may have been preempted
+        // and the reader gives its processor away
+        unsigned long sequence =
+            __atomic_load_n(&tree->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1)
+        {
+            if (spins >= RB_READER_SPINS)
+            {
+                sched_yield();
+            }
+            continue;
+        }
+
+        // Nodes reached here are never freed before the reader leaves, but
+        // a writer may move them: the result only counts if no writer ran
+        RB_Node *node = __atomic_load_n(&tree->tree->root, __ATOMIC_ACQUIRE);
+        int found = 0;
+        T value = data;
+        for (size_t depth = 0; node != nil && depth < RB_MAX_DEPTH; depth++)
+        {
+            int cmp = compCMP(data, node->data);
+            if (cmp == 0)
+            {
+                found = 1;
+                value = node->data;
+                break;
+            }
+            RB_Node **child = cmp < 0 ? &node->left : &node->right;
+            node = __atomic_load_n(child, __ATOMIC_ACQUIRE);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&tree->sequence, __ATOMIC_RELAXED) == sequence)
+        {
+            __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+            if (found && out)
+            {
+                *out = value;
+            }
+            return found;
+        }
+    }
+}
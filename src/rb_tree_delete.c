@@ -7,99 +7,93 @@
  * node deletion */
 static void deleteFixup(RB_Tree *tree, RB_Node *x)
 {
-    while (x != tree->root && x->color == BLACK)
+    while (x != tree->root && rb_color(x) == BLACK)
     {
+        RB_STAT(tree, delete_fixups);
         // Case when x is a left child
-        if (x == x->parent->left)
+        if (x == rb_parent(x)->left)
         {
-            RB_Node *w = x->parent->right; // sibling of x
+            RB_Node *w = rb_parent(x)->right; // sibling of x
 
             // Case 1: x's sibling w is red
-            if (w->color == RED)
+            if (rb_color(w) == RED)
             {
-                w->color = BLACK;
-                x->parent->color = RED;
-                rb_rotate_left(tree, x->parent);
-                w = x->parent->right;
+                rb_set_color(w, BLACK);
+                rb_set_color(rb_parent(x), RED);
+                rb_rotate_left(tree, rb_parent(x));
+                w = rb_parent(x)->right;
             }
 
             // Case 2: Both of w's children are black
-            if (w->left->color == BLACK && w->right->color == BLACK)
+            if (rb_color(w->left) == BLACK && rb_color(w->right) == BLACK)
             {
-                w->color = RED;
-                x = x->parent;
+                rb_set_color(w, RED);
+                x = rb_parent(x);
             }
             else
             {
                 // Case 3: w's right child is black
-                if (w->right->color == BLACK)
+                if (rb_color(w->right) == BLACK)
                 {
-                    w->left->color = BLACK;
-                    w->color = RED;
+                    rb_set_color(w->left, BLACK);
+                    rb_set_color(w, RED);
                     rb_rotate_right(tree, w);
-                    w = x->parent->right;
+                    w = rb_parent(x)->right;
                 }
                 // Case 4: w's right child is red
-                w->color = x->parent->color;
-                x->parent->color = BLACK;
-                w->right->color = BLACK;
-                rb_rotate_left(tree, x->parent);
+                rb_set_color(w, rb_color(rb_parent(x)));
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(w->right, BLACK);
+                rb_rotate_left(tree, rb_parent(x));
                 x = tree->root;
             }
         }
         else
         {
             // Mirror cases when x is a right child
-            RB_Node *w = x->parent->left;
+            RB_Node *w = rb_parent(x)->left;
 
-            if (w->color == RED)
+            if (rb_color(w) == RED)
             {
-                w->color = BLACK;
-                x->parent->color = RED;
-                rb_rotate_right(tree, x->parent);
-                w = x->parent->left;
+                rb_set_color(w, BLACK);
+                rb_set_color(rb_parent(x), RED);
+                rb_rotate_right(tree, rb_parent(x));
+                w = rb_parent(x)->left;
             }
 
-            if (w->right->color == BLACK && w->left->color == BLACK)
+            if (rb_color(w->right) == BLACK && rb_color(w->left) == BLACK)
             {
-                w->color = RED;
-                x = x->parent;
+                rb_set_color(w, RED);
+                x = rb_parent(x);
             }
             else
             {
-                if (w->left->color == BLACK)
+                if (rb_color(w->left) == BLACK)
                 {
-                    w->right->color = BLACK;
-                    w->color = RED;
+                    rb_set_color(w->right, BLACK);
+                    rb_set_color(w, RED);
                     rb_rotate_left(tree, w);
-                    w = x->parent->left;
+                    w = rb_parent(x)->left;
                 }
-                w->color = x->parent->color;
-                x->parent->color = BLACK;
-                w->left->color = BLACK;
-                rb_rotate_right(tree, x->parent);
+                rb_set_color(w, rb_color(rb_parent(x)));
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(w->left, BLACK);
+                rb_rotate_right(tree, rb_parent(x));
                 x = tree->root;
             }
         }
     }
-    x->color = BLACK; // Ensure the root remains black
+    rb_set_color(x, BLACK); // Ensure the root remains black
 }
 
-/* deleteNode function removes a node from the red-black tree */
-void rb_delete(RB_Tree *tree, RB_Node *z)
+/* unlinkNode function removes a node from the red-black tree without freeing
+ * it. When z has two children, its successor is unlinked and relinked in place
+ * of z, so that z itself leaves the tree and every other node keeps its
+ * address and its data. The fields of z are left as they were */
+void rb_unlink(RB_Tree *tree, RB_Node *z)
 {
     RB_Node *x, *y;
-
-    if (!tree)
-    {
-        return;
-    }
-
-    // Return if the node to delete is NULL or tree's sentinel node
-    if (!z || z == &tree->nil)
-    {
-        return;
-    }
+    RB_Color removed_color;
 
     // Determine the node y to splice out, which is either z or its successor
     if (z->left == &tree->nil || z->right == &tree->nil)
@@ -125,45 +119,120 @@ void rb_delete(RB_Tree *tree, RB_Node *z)
         x = y->right;
     }
 
+#ifdef RB_ORDER_STATISTICS
+    // Every ancestor of y loses one node
+    for (RB_Node *p = rb_parent(y); p; p = rb_parent(p))
+    {
+        p->size--;
+    }
+#endif // RB_ORDER_STATISTICS
+
     // Remove y from the parent chain
-    x->parent = y->parent;
-    if (y->parent)
+    rb_set_parent(x, rb_parent(y));
+    if (rb_parent(y))
     {
-        if (y == y->parent->left)
+        if (y == rb_parent(y)->left)
         {
-            y->parent->left = x;
+            rb_parent(y)->left = x;
         }
         else
         {
-            y->parent->right = x;
+            rb_parent(y)->right = x;
         }
     }
     else
     {
         tree->root = x;
     }
+    removed_color = rb_color(y);
 
-    // If y is a copy of z (successor case), transfer z's data to y
+    // If y is z's successor, move y into z's position instead of copying data
     if (y != z)
     {
-        z->data = y->data;
+        rb_set_parent(y, rb_parent(z));
+        y->left = z->left;
+        y->right = z->right;
+        rb_set_color(y, rb_color(z));
+#ifdef RB_ORDER_STATISTICS
+        y->size = z->size;
+#endif // RB_ORDER_STATISTICS
+
+        if (rb_parent(z))
+        {
+            if (z == rb_parent(z)->left)
+            {
+                rb_parent(z)->left = y;
+            }
+            else
+            {
+                rb_parent(z)->right = y;
+            }
+        }
+        else
+        {
+            tree->root = y;
+        }
+
+        if (y->left != &tree->nil)
+        {
+            rb_set_parent(y->left, y);
+        }
+        if (y->right != &tree->nil)
+        {
+            rb_set_parent(y->right, y);
+        }
+        if (rb_parent(x) == z)
+        {
+            rb_set_parent(x, y);
+        }
     }
 
     // Fix-up any violations of red-black properties
-    if (y->color == BLACK)
+    if (removed_color == BLACK)
     {
         deleteFixup(tree, x);
     }
 
-    // Free the memory of the spliced-out node
-    free(y);
+    tree->size--;
+    tree->generation++;
+    RB_STAT(tree, deletes);
 
     if (tree->root == &tree->nil)
     {
-        tree->nil.parent = &tree->nil;
+        rb_set_parent(&tree->nil, &tree->nil);
     }
     else
     {
-        tree->root->parent = NULL;
+        rb_set_parent(tree->root, NULL);
+    }
+}
+
+void rb_delete(RB_Tree *tree, RB_Node *z)
+{
+    if (!tree)
+    {
+        return;
+    }
+
+    // Return if the node to delete is NULL or tree's sentinel node
+    if (!z || z == &tree->nil)
+    {
+        return;
+    }
+
+    rb_unlink(tree, z);
+
+    // Free the memory of the deleted node
+    rb_node_free(tree, z);
+}
+
+int rb_erase(RB_Tree *tree, T data)
+{
+    RB_Node *node = rb_find(tree, data);
+    if (!node)
+    {
+        return 0;
     }
+    rb_delete(tree, node);
+    return 1;
 }
@@ -1,20 +1,62 @@
-#include "../rb_tree.h"
+#include "rb_tree_internal.h"
 
-static void rb_delete_node_recursive(RB_Tree *tree, RB_Node *node)
+/* Walk the tree without recursion nor stack: a node with a left child is
+ * rotated right until the leftmost node is on top, and a node without a left
+ * child is released before moving to its right child */
+static void rb_destroy_nodes(RB_Tree *tree, RB_Destructor destructor,
+                             void *ctx, int release)
 {
-    if (node != &tree->nil)
+    RB_Node *node = tree->root;
+    while (node != &tree->nil)
     {
-        rb_delete_node_recursive(tree, node->left);
-        rb_delete_node_recursive(tree, node->right);
-        free(node);
+        RB_Node *left = node->left;
+        if (left != &tree->nil)
+        {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        }
+        else
+        {
+            RB_Node *right = node->right;
+            if (destructor)
+            {
+                destructor(node->data, ctx);
+            }
+            if (release)
+            {
+                rb_node_free(tree, node);
+            }
+            node = right;
+        }
     }
 }
 
-void rb_tree_destroy(RB_Tree *tree)
+void rb_tree_destroy_with(RB_Tree *tree, RB_Destructor destructor, void *ctx)
 {
     if (tree)
     {
-        rb_delete_node_recursive(tree, tree->root);
-        free(tree);
+        RB_Allocator allocator = tree->allocator;
+
+        // Pooled nodes live in slabs and arena nodes are reclaimed by their
+        // owner, so nodes are only visited when they must be freed one by one
+        // or when their data must be destroyed. A pool shared with other
+        // trees outlives this one and takes the nodes back
+        int release =
+            tree->pool ? tree->pool->refs > 1 : allocator.free != NULL;
+        if (release || destructor)
+        {
+            rb_destroy_nodes(tree, destructor, ctx, release);
+        }
+        if (tree->pool)
+        {
+            rb_pool_destroy(tree->pool);
+        }
+        rb_free(&allocator, tree, sizeof(RB_Tree));
     }
 }
+
+void rb_tree_destroy(RB_Tree *tree)
+{
+    rb_tree_destroy_with(tree, NULL, NULL);
+}
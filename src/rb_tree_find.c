@@ -1,4 +1,4 @@
-#include "../rb_tree.h"
+#include "rb_tree_internal.h"
 
 RB_Node *rb_find(RB_Tree *tree, T data)
 {
@@ -8,17 +8,78 @@ RB_Node *rb_find(RB_Tree *tree, T data)
     }
 
     RB_Node *current = tree->root;
+    size_t depth = 0;
     while (current != &tree->nil)
     {
-        if (compEQ(data, current->data))
+        int cmp = compCMP(data, current->data);
+        depth++;
+        if (cmp == 0)
         {
+            RB_STAT_DESCENT(tree, depth);
             return (current);
         }
+        current = cmp < 0 ? current->left : current->right;
+    }
+    RB_STAT_DESCENT(tree, depth);
+    return NULL;
+}
+
+#ifdef RB_ORDER_STATISTICS
+RB_Node *rb_select(RB_Tree *tree, size_t k)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        size_t left = current->left->size;
+        if (k < left)
+        {
+            current = current->left;
+        }
+        else if (k > left)
+        {
+            k -= left + 1;
+            current = current->right;
+        }
         else
         {
-            current =
-                compLT(data, current->data) ? current->left : current->right;
+            return (current);
         }
     }
     return NULL;
 }
+
+size_t rb_rank(RB_Tree *tree, T data)
+{
+    size_t rank = 0;
+
+    if (!tree)
+    {
+        return 0;
+    }
+
+    RB_Node *current = tree->root;
+    while (current != &tree->nil)
+    {
+        int cmp = compCMP(data, current->data);
+        if (cmp == 0)
+        {
+            return rank + current->left->size;
+        }
+        if (cmp < 0)
+        {
+            current = current->left;
+        }
+        else
+        {
+            rank += current->left->size + 1;
+            current = current->right;
+        }
+    }
+    return rank;
+}
+#endif // RB_ORDER_STATISTICS
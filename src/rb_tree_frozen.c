@@ -0,0 +1,159 @@
+#include "rb_tree_internal.h"
+
+/* Copy the keys of the tree in order into the Eytzinger positions 1..n, which
+ * are visited by an in-order walk of the implicit tree they form */
+static void rb_frozen_fill(T *keys, size_t n, RB_Tree *tree)
+{
+    size_t k = 1;
+    while (2 * k <= n)
+    {
+        k *= 2;
+    }
+
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        keys[k] = node->data;
+        if (2 * k + 1 <= n)
+        {
+            // Leftmost position of the right subtree
+            k = 2 * k + 1;
+            while (2 * k <= n)
+            {
+                k *= 2;
+            }
+        }
+        else
+        {
+            // Climb up past the right turns, then past one left turn
+            while (k & 1)
+            {
+                k >>= 1;
+            }
+            k >>= 1;
+        }
+    }
+}
+
+static int rb_frozen_load(RB_Frozen *frozen, RB_Tree *tree)
+{
+    if (tree->size > frozen->capacity || !frozen->keys)
+    {
+        T *keys = rb_alloc(&frozen->allocator, (tree->size + 1) * sizeof(T));
+        if (!keys)
+        {
+            fprintf(stderr, "insufficient memory (rb_tree_freeze)\n");
+            return -1;
+        }
+        if (frozen->keys)
+        {
+            rb_free(&frozen->allocator, frozen->keys,
+                    (frozen->capacity + 1) * sizeof(T));
+        }
+        frozen->keys = keys;
+        frozen->capacity = tree->size;
+    }
+
+    rb_frozen_fill(frozen->keys, tree->size, tree);
+    frozen->size = tree->size;
+    frozen->generation = tree->generation;
+    return 0;
+}
+
+RB_Frozen *rb_tree_freeze(RB_Tree *tree)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Frozen *frozen = rb_alloc(&tree->allocator, sizeof(RB_Frozen));
+    if (!frozen)
+    {
+        fprintf(stderr, "insufficient memory (rb_tree_freeze)\n");
+        return NULL;
+    }
+    frozen->allocator = tree->allocator;
+    frozen->keys = NULL;
+    frozen->size = 0;
+    frozen->capacity = 0;
+
+    if (rb_frozen_load(frozen, tree) != 0)
+    {
+        rb_free(&frozen->allocator, frozen, sizeof(RB_Frozen));
+        return NULL;
+    }
+    return frozen;
+}
+
+int rb_frozen_refresh(RB_Frozen *frozen, RB_Tree *tree)
+{
+    if (!frozen || !tree)
+    {
+        return -1;
+    }
+    if (frozen->generation == tree->generation)
+    {
+        return 0;
+    }
+    return rb_frozen_load(frozen, tree);
+}
+
+/* Return the position of the smallest key >= data, or 0. The descent always
+ * runs to the bottom of the implicit tree, turning right past smaller keys,
+ * so that it has no branch to mispredict. The answer is where it last turned
+ * left, found by dropping the trailing right turns and that left turn */
+static size_t rb_frozen_search(const RB_Frozen *frozen, T data)
+{
+    const T *keys = frozen->keys;
+    size_t n = frozen->size;
+    size_t k = 1;
+
+    while (k <= n)
+    {
+        if (k * RB_FROZEN_STRIDE <= n)
+        {
+            RB_PREFETCH(keys + k * RB_FROZEN_STRIDE);
+        }
+        k = 2 * k + (compCMP(keys[k], data) < 0);
+    }
+
+    while (k & 1)
+    {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+const T *rb_frozen_lower_bound(const RB_Frozen *frozen, T data)
+{
+    if (!frozen)
+    {
+        return NULL;
+    }
+
+    size_t k = rb_frozen_search(frozen, data);
+    return k ? &frozen->keys[k] : NULL;
+}
+
+const T *rb_frozen_find(const RB_Frozen *frozen, T data)
+{
+    const T *key = rb_frozen_lower_bound(frozen, data);
+    return key && compCMP(*key, data) == 0 ? key : NULL;
+}
+
+size_t rb_frozen_size(const RB_Frozen *frozen)
+{
+    return frozen ? frozen->size : 0;
+}
+
+void rb_frozen_destroy(RB_Frozen *frozen)
+{
+    if (!frozen)
+    {
+        return;
+    }
+
+    RB_Allocator allocator = frozen->allocator;
+    rb_free(&allocator, frozen->keys, (frozen->capacity + 1) * sizeof(T));
+    rb_free(&allocator, frozen, sizeof(RB_Frozen));
+}
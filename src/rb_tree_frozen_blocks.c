@@ -0,0 +1,261 @@
+#include "rb_tree_internal.h"
+
+#if defined(RB_T_INT) && defined(__GNUC__)                                    \
+    && (defined(__x86_64__) || defined(__i386__))
+#    define RB_BLOCK_SIMD
+#    include <immintrin.h>
+#endif
+
+// Block search
+
+static unsigned rb_block_rank_scalar(const T *block, T data)
+{
+    unsigned rank = 0;
+    for (int i = 0; i < RB_BLOCK_KEYS; i++)
+    {
+        rank += compCMP(block[i], data) < 0;
+    }
+    return rank;
+}
+
+#ifdef RB_BLOCK_SIMD
+__attribute__((target("avx512f,popcnt"))) static unsigned
+rb_block_rank_avx512(const T *block, T data)
+{
+    __m512i keys = _mm512_load_si512((const void *)block);
+    __mmask16 less = _mm512_cmplt_epi32_mask(keys, _mm512_set1_epi32(data));
+    return __builtin_popcount(less);
+}
+
+__attribute__((target("avx2,popcnt"))) static unsigned
+rb_block_rank_avx2(const T *block, T data)
+{
+    __m256i key = _mm256_set1_epi32(data);
+    __m256i low = _mm256_load_si256((const __m256i *)block);
+    __m256i high = _mm256_load_si256((const __m256i *)(block + 8));
+    unsigned less =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, low)))
+        | _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, high)))
+            << 8;
+    return __builtin_popcount(less);
+}
+
+__attribute__((target("sse2"))) static unsigned
+rb_block_rank_sse2(const T *block, T data)
+{
+    __m128i key = _mm_set1_epi32(data);
+    const __m128i *keys = (const __m128i *)block;
+    __m128i less01 = _mm_packs_epi32(_mm_cmpgt_epi32(key, keys[0]),
+                                     _mm_cmpgt_epi32(key, keys[1]));
+    __m128i less23 = _mm_packs_epi32(_mm_cmpgt_epi32(key, keys[2]),
+                                     _mm_cmpgt_epi32(key, keys[3]));
+    return __builtin_popcount(
+        _mm_movemask_epi8(_mm_packs_epi16(less01, less23)));
+}
+#endif // RB_BLOCK_SIMD
+
+/* Pick the widest block search the processor supports */
+static void rb_block_select(RB_FrozenBlocks *frozen)
+{
+#ifdef RB_BLOCK_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        frozen->rank = rb_block_rank_avx512;
+        frozen->isa = "avx512";
+        return;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        frozen->rank = rb_block_rank_avx2;
+        frozen->isa = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        frozen->rank = rb_block_rank_sse2;
+        frozen->isa = "sse2";
+        return;
+    }
+#endif // RB_BLOCK_SIMD
+    frozen->rank = rb_block_rank_scalar;
+    frozen->isa = "scalar";
+}
+
+// Building
+
+typedef struct
+{
+    RB_Tree *tree;
+    RB_Node *node;
+    T *keys;
+    size_t blocks;
+    T pad;
+} RB_BlockFiller;
+
+/* Fill block k and its subtree by an in-order walk of the implicit B-tree,
+ * taking the keys of the tree in order and padding after the last one */
+static void rb_block_fill(RB_BlockFiller *filler, size_t k)
+{
+    if (k >= filler->blocks)
+    {
+        return;
+    }
+
+    size_t first_child = k * (RB_BLOCK_KEYS + 1) + 1;
+    for (size_t i = 0; i < RB_BLOCK_KEYS; i++)
+    {
+        rb_block_fill(filler, first_child + i);
+        if (filler->node)
+        {
+            filler->keys[k * RB_BLOCK_KEYS + i] = filler->node->data;
+            filler->node = rb_next(filler->tree, filler->node);
+        }
+        else
+        {
+            filler->keys[k * RB_BLOCK_KEYS + i] = filler->pad;
+        }
+    }
+    rb_block_fill(filler, first_child + RB_BLOCK_KEYS);
+}
+
+static size_t rb_blocks_bytes(size_t blocks)
+{
+    return blocks * RB_BLOCK_KEYS * sizeof(T) + RB_BLOCK_ALIGN - 1;
+}
+
+static int rb_frozen_blocks_load(RB_FrozenBlocks *frozen, RB_Tree *tree)
+{
+    size_t blocks = (tree->size + RB_BLOCK_KEYS - 1) / RB_BLOCK_KEYS;
+
+    if (blocks > frozen->capacity || !frozen->memory)
+    {
+        void *memory = rb_alloc(&frozen->allocator, rb_blocks_bytes(blocks));
+        if (!memory)
+        {
+            fprintf(stderr, "insufficient memory (rb_tree_freeze_blocks)\n");
+            return -1;
+        }
+        if (frozen->memory)
+        {
+            rb_free(&frozen->allocator, frozen->memory,
+                    rb_blocks_bytes(frozen->capacity));
+        }
+        frozen->memory = memory;
+        frozen->keys =
+            (T *)(((uintptr_t)memory + RB_BLOCK_ALIGN - 1)
+                  & ~(uintptr_t)(RB_BLOCK_ALIGN - 1));
+        frozen->capacity = blocks;
+    }
+
+    if (blocks > 0)
+    {
+        RB_BlockFiller filler = { tree, rb_first(tree), frozen->keys, blocks,
+                                  rb_last(tree)->data };
+        rb_block_fill(&filler, 0);
+    }
+    frozen->size = tree->size;
+    frozen->blocks = blocks;
+    frozen->generation = tree->generation;
+    return 0;
+}
+
+RB_FrozenBlocks *rb_tree_freeze_blocks(RB_Tree *tree)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_FrozenBlocks *frozen =
+        rb_alloc(&tree->allocator, sizeof(RB_FrozenBlocks));
+    if (!frozen)
+    {
+        fprintf(stderr, "insufficient memory (rb_tree_freeze_blocks)\n");
+        return NULL;
+    }
+    frozen->allocator = tree->allocator;
+    frozen->memory = NULL;
+    frozen->keys = NULL;
+    frozen->size = 0;
+    frozen->blocks = 0;
+    frozen->capacity = 0;
+    rb_block_select(frozen);
+
+    if (rb_frozen_blocks_load(frozen, tree) != 0)
+    {
+        rb_free(&frozen->allocator, frozen, sizeof(RB_FrozenBlocks));
+        return NULL;
+    }
+    return frozen;
+}
+
+int rb_frozen_blocks_refresh(RB_FrozenBlocks *frozen, RB_Tree *tree)
+{
+    if (!frozen || !tree)
+    {
+        return -1;
+    }
+    if (frozen->generation == tree->generation)
+    {
+        return 0;
+    }
+    return rb_frozen_blocks_load(frozen, tree);
+}
+
+// Queries
+
+const T *rb_frozen_blocks_lower_bound(const RB_FrozenBlocks *frozen, T data)
+{
+    if (!frozen)
+    {
+        return NULL;
+    }
+
+    // The answer is the first key >= data of the last block where there was
+    // one, each block sending the search to the child between its keys
+    const T *result = NULL;
+    size_t k = 0;
+    while (k < frozen->blocks)
+    {
+        const T *block = frozen->keys + k * RB_BLOCK_KEYS;
+        unsigned rank = frozen->rank(block, data);
+        if (rank < RB_BLOCK_KEYS)
+        {
+            result = block + rank;
+        }
+        k = k * (RB_BLOCK_KEYS + 1) + 1 + rank;
+    }
+    return result;
+}
+
+const T *rb_frozen_blocks_find(const RB_FrozenBlocks *frozen, T data)
+{
+    const T *key = rb_frozen_blocks_lower_bound(frozen, data);
+    return key && compCMP(*key, data) == 0 ? key : NULL;
+}
+
+size_t rb_frozen_blocks_size(const RB_FrozenBlocks *frozen)
+{
+    return frozen ? frozen->size : 0;
+}
+
+const char *rb_frozen_blocks_isa(const RB_FrozenBlocks *frozen)
+{
+    return frozen ? frozen->isa : NULL;
+}
+
+void rb_frozen_blocks_destroy(RB_FrozenBlocks *frozen)
+{
+    if (!frozen)
+    {
+        return;
+    }
+
+    RB_Allocator allocator = frozen->allocator;
+    if (frozen->memory)
+    {
+        rb_free(&allocator, frozen->memory, rb_blocks_bytes(frozen->capacity));
+    }
+    rb_free(&allocator, frozen, sizeof(RB_FrozenBlocks));
+}
@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rb_tree_internal.h"
+
+// File access
+
+/* Write all of buffer, resuming after partial writes and signals */
+static int rb_write_all(int fd, const void *buffer, size_t length)
+{
+    const char *bytes = buffer;
+    while (length > 0)
+    {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+/* Read exactly length bytes, an early end of file being an invalid image */
+static int rb_read_all(int fd, void *buffer, size_t length)
+{
+    char *bytes = buffer;
+    while (length > 0)
+    {
+        ssize_t got = read(fd, bytes, length);
+        if (got < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (got == 0)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        bytes += got;
+        length -= (size_t)got;
+    }
+    return 0;
+}
+
+/* Bytes left to read in a regular file, 0 when fd is anything else */
+static size_t rb_bytes_left(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return 0;
+    }
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0 || offset > st.st_size)
+    {
+        return 0;
+    }
+    return (size_t)(st.st_size - offset);
+}
+
+// Header
+
+static void rb_image_header_init(RB_ImageHeader *header, size_t count)
+{
+    memset(header, 0, sizeof(RB_ImageHeader));
+    memcpy(header->magic, RB_IMAGE_MAGIC, sizeof(header->magic));
+    header->version = RB_IMAGE_VERSION;
+    header->byte_order = RB_IMAGE_BYTE_ORDER;
+    header->key_size = sizeof(T);
+    header->count = count;
+}
+
+/* Check that this build can read the image header describes */
+static int rb_image_header_check(const RB_ImageHeader *header)
+{
+    if (memcmp(header->magic, RB_IMAGE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != RB_IMAGE_VERSION
+        || header->byte_order != RB_IMAGE_BYTE_ORDER
+        || header->key_size != sizeof(T) || header->flags != 0
+        || header->count > SIZE_MAX / sizeof(T))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+// Saving and loading
+
+int rb_tree_save(RB_Tree *tree, int fd)
+{
+    if (!tree)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    RB_ImageHeader header;
+    rb_image_header_init(&header, tree->size);
+    if (rb_write_all(fd, &header, sizeof(header)) != 0)
+    {
+        return -1;
+    }
+
+    T chunk[RB_IMAGE_CHUNK];
+    size_t count = 0;
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        chunk[count++] = node->data;
+        if (count == RB_IMAGE_CHUNK)
+        {
+            if (rb_write_all(fd, chunk, sizeof(chunk)) != 0)
+            {
+                return -1;
+            }
+            count = 0;
+        }
+    }
+    return rb_write_all(fd, chunk, count * sizeof(T));
+}
+
+/* Read count keys into a chain of new nodes linked by the right pointer,
+ * checking that they are strictly ascending */
+static RB_Node *rb_image_read_chain(RB_Tree *tree, int fd, size_t count)
+{
+    RB_Node head;
+    RB_Node *tail = &head;
+    T chunk[RB_IMAGE_CHUNK];
+
+    for (size_t done = 0; done < count;)
+    {
+        size_t n = count - done < RB_IMAGE_CHUNK ? count - done
+                                                 : RB_IMAGE_CHUNK;
+        if (rb_read_all(fd, chunk, n * sizeof(T)) != 0)
+        {
+            return NULL;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            if (tail != &head && compCMP(tail->data, chunk[i]) >= 0)
+            {
+                errno = EINVAL;
+                return NULL;
+            }
+            RB_Node *node = rb_node_alloc(tree);
+            if (!node)
+            {
+                fprintf(stderr, "insufficient memory (rb_tree_load)\n");
+                return NULL;
+            }
+            node->data = chunk[i];
+            tail->right = node;
+            tail = node;
+        }
+        done += n;
+    }
+    tail->right = NULL;
+    return head.right;
+}
+
+RB_Tree *rb_tree_load(int fd)
+{
+    RB_ImageHeader header;
+    if (rb_read_all(fd, &header, sizeof(header)) != 0
+        || rb_image_header_check(&header) != 0)
+    {
+        return NULL;
+    }
+    size_t count = (size_t)header.count;
+
+    // Reserve every node at once only when the file holds them all, so that
+    // a corrupt count cannot ask for any amount of memory
+    size_t reserve = rb_bytes_left(fd) / sizeof(T) >= count ? count : 0;
+    RB_Tree *tree = rb_tree_new_with_pool(reserve);
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Node *chain = rb_image_read_chain(tree, fd, count);
+    if (!chain && count > 0)
+    {
+        // The nodes read so far are in the pool and go with it
+        rb_tree_destroy(tree);
+        return NULL;
+    }
+    rb_build_from_chain(tree, chain, count);
+    return tree;
+}
+
+// Mapped images
+
+RB_Mapped *rb_tree_map(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode)
+        || (uintmax_t)st.st_size < sizeof(RB_ImageHeader)
+        || (uintmax_t)st.st_size > SIZE_MAX)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t length = (size_t)st.st_size;
+    void *base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const RB_ImageHeader *header = base;
+    if (rb_image_header_check(header) != 0
+        || header->count > (length - sizeof(RB_ImageHeader)) / sizeof(T))
+    {
+        munmap(base, length);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    RB_Mapped *mapped = rb_alloc(&rb_default_allocator, sizeof(RB_Mapped));
+    if (!mapped)
+    {
+        fprintf(stderr, "insufficient memory (rb_tree_map)\n");
+        munmap(base, length);
+        return NULL;
+    }
+    mapped->base = base;
+    mapped->length = length;
+    mapped->keys = (const T *)(header + 1);
+    mapped->size = (size_t)header->count;
+    return mapped;
+}
+
+const T *rb_mapped_lower_bound(const RB_Mapped *mapped, T data)
+{
+    if (!mapped || mapped->size == 0)
+    {
+        return NULL;
+    }
+
+    // The answer stays within base..base + n, halving n with a conditional
+    // move rather than a branch, while both possible next probes are fetched
+    const T *base = mapped->keys;
+    size_t n = mapped->size;
+    while (n > 1)
+    {
+        size_t half = n / 2;
+        RB_PREFETCH(base + (n - half) / 2);
+        RB_PREFETCH(base + half + (n - half) / 2);
+        base += compCMP(base[half], data) < 0 ? half : 0;
+        n -= half;
+    }
+    base += compCMP(*base, data) < 0;
+    return base < mapped->keys + mapped->size ? base : NULL;
+}
+
+const T *rb_mapped_find(const RB_Mapped *mapped, T data)
+{
+    const T *key = rb_mapped_lower_bound(mapped, data);
+    return key && compCMP(*key, data) == 0 ? key : NULL;
+}
+
+size_t rb_mapped_size(const RB_Mapped *mapped)
+{
+    return mapped ? mapped->size : 0;
+}
+
+void rb_mapped_destroy(RB_Mapped *mapped)
+{
+    if (!mapped)
+    {
+        return;
+    }
+
+    munmap(mapped->base, mapped->length);
+    rb_free(&rb_default_allocator, mapped, sizeof(RB_Mapped));
+}
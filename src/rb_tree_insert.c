@@ -1,93 +1,114 @@
 #include "rb_tree_internal.h"
 
-static void insertFixup(RB_Tree *tree, RB_Node *x)
+void rb_insert_fixup(RB_Tree *tree, RB_Node *x)
 {
-    while (x != tree->root && x->parent->color == RED)
+    while (rb_parent(x) && rb_color(rb_parent(x)) == RED)
     {
-        if (x->parent == x->parent->parent->left)
+        RB_STAT(tree, insert_fixups);
+        if (rb_parent(x) == rb_parent(rb_parent(x))->left)
         {
-            RB_Node *y = x->parent->parent->right;
-            if (y->color == RED)
+            RB_Node *y = rb_parent(rb_parent(x))->right;
+            if (rb_color(y) == RED)
             {
-                x->parent->color = BLACK;
-                y->color = BLACK;
-                x->parent->parent->color = RED;
-                x = x->parent->parent;
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(y, BLACK);
+                rb_set_color(rb_parent(rb_parent(x)), RED);
+                x = rb_parent(rb_parent(x));
             }
             else
             {
-                if (x == x->parent->right)
+                if (x == rb_parent(x)->right)
                 {
-                    x = x->parent;
+                    x = rb_parent(x);
                     rb_rotate_left(tree, x);
                 }
 
-                x->parent->color = BLACK;
-                x->parent->parent->color = RED;
-                rb_rotate_right(tree, x->parent->parent);
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(rb_parent(rb_parent(x)), RED);
+                rb_rotate_right(tree, rb_parent(rb_parent(x)));
             }
         }
         else
         {
-            RB_Node *y = x->parent->parent->left;
-            if (y->color == RED)
+            RB_Node *y = rb_parent(rb_parent(x))->left;
+            if (rb_color(y) == RED)
             {
-                x->parent->color = BLACK;
-                y->color = BLACK;
-                x->parent->parent->color = RED;
-                x = x->parent->parent;
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(y, BLACK);
+                rb_set_color(rb_parent(rb_parent(x)), RED);
+                x = rb_parent(rb_parent(x));
             }
             else
             {
-                if (x == x->parent->left)
+                if (x == rb_parent(x)->left)
                 {
-                    x = x->parent;
+                    x = rb_parent(x);
                     rb_rotate_right(tree, x);
                 }
-                x->parent->color = BLACK;
-                x->parent->parent->color = RED;
-                rb_rotate_left(tree, x->parent->parent);
+                rb_set_color(rb_parent(x), BLACK);
+                rb_set_color(rb_parent(rb_parent(x)), RED);
+                rb_rotate_left(tree, rb_parent(rb_parent(x)));
             }
         }
     }
-    tree->root->color = BLACK;
+    if (!rb_parent(x))
+    {
+        rb_set_color(x, BLACK);
+    }
 }
 
-RB_Node *rb_insert(RB_Tree *tree, T data)
+RB_Node *rb_insert_from(RB_Tree *tree, RB_Node *current, T data,
+                        int *inserted)
 {
-    RB_Node *current, *parent, *x;
+    RB_Node *parent, *x;
+    int cmp = 0;
+    size_t depth = 0;
 
-    if (!tree)
+    if (inserted)
     {
-        return NULL;
+        *inserted = 0;
     }
 
-    current = tree->root;
     parent = 0;
     while (current != &tree->nil)
     {
-        if (compEQ(data, current->data))
+        cmp = compCMP(data, current->data);
+        depth++;
+        if (cmp == 0)
         {
+            RB_STAT_DESCENT(tree, depth);
             return (current);
         }
         parent = current;
-        current = compLT(data, current->data) ? current->left : current->right;
+        current = cmp < 0 ? current->left : current->right;
     }
 
-    if ((x = malloc(sizeof(*x))) == NULL)
+    RB_STAT_DESCENT(tree, depth);
+
+    if ((x = rb_node_alloc(tree)) == NULL)
     {
         fprintf(stderr, "insufficient memory (rb_insert)\n");
         return NULL;
     }
     x->data = data;
-    x->parent = parent;
+    rb_set_parent_color(x, parent, RED);
     x->left = &tree->nil;
     x->right = &tree->nil;
-    x->color = RED;
+    tree->size++;
+    tree->generation++;
+    RB_STAT(tree, inserts);
+#ifdef RB_ORDER_STATISTICS
+    x->size = 1;
+    for (current = parent; current; current = rb_parent(current))
+    {
+        current->size++;
+    }
+#endif // RB_ORDER_STATISTICS
 
+    RB_RELEASE_FENCE();
     if (parent)
     {
-        if (compLT(data, parent->data))
+        if (cmp < 0)
         {
             parent->left = x;
         }
@@ -101,10 +122,53 @@ RB_Node *rb_insert(RB_Tree *tree, T data)
         tree->root = x;
     }
 
-    insertFixup(tree, x);
+    rb_insert_fixup(tree, x);
     if (tree->root != &tree->nil)
     {
-        tree->root->parent = NULL;
+        rb_set_parent(tree->root, NULL);
+    }
+    if (inserted)
+    {
+        *inserted = 1;
     }
     return (x);
 }
+
+RB_Node *rb_insert(RB_Tree *tree, T data)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+    return rb_insert_from(tree, tree->root, data, NULL);
+}
+
+RB_Node *rb_find_or_insert(RB_Tree *tree, T data, int *inserted)
+{
+    if (!tree)
+    {
+        if (inserted)
+        {
+            *inserted = 0;
+        }
+        return NULL;
+    }
+    return rb_insert_from(tree, tree->root, data, inserted);
+}
+
+RB_Node *rb_upsert(RB_Tree *tree, T data, int *inserted)
+{
+    int created;
+    RB_Node *node = rb_find_or_insert(tree, data, &created);
+    if (node && !created)
+    {
+        // Same key, but T may carry more than its key
+        node->data = data;
+        tree->generation++;
+    }
+    if (inserted)
+    {
+        *inserted = created;
+    }
+    return node;
+}
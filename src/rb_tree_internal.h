@@ -1,8 +1,357 @@
 #ifndef RB_TREE_INTERNAL_H
 #define RB_TREE_INTERNAL_H
 
+#include <pthread.h>
+
 #include "../rb_tree.h"
 
+// Compiler hints
+
+/* Ask the hardware to start loading a node that will be needed soon */
+#if defined(__GNUC__)
+#    define RB_PREFETCH(p) __builtin_prefetch(p)
+#else
+#    define RB_PREFETCH(p) ((void)(p))
+#endif
+
+/* Order the stores that initialize a node before the store that links it, so
+ * that concurrent readers (rb_concurrent_find) never see it half built */
+#if defined(__GNUC__)
+#    define RB_RELEASE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#    define RB_RELEASE_FENCE() ((void)0)
+#endif
+
+// Instrumentation
+
+/* Count an event in the counters of a tree, or record a descent that compared
+ * depth keys. Both vanish without RB_STATS */
+#ifdef RB_STATS
+#    define RB_STAT(tree, counter) ((tree)->stats.counter++)
+#    define RB_STAT_DESCENT(tree, depth)                                     \
+        rb_stat_descent(&(tree)->stats, (depth))
+#else
+#    define RB_STAT(tree, counter) ((void)0)
+#    define RB_STAT_DESCENT(tree, depth) ((void)(depth))
+#endif // RB_STATS
+
+#ifdef RB_STATS
+void rb_stat_descent(RB_Stats *stats, size_t depth);
+#endif // RB_STATS
+
+// Allocation
+
+/* Allocator used when none is given (malloc and free) */
+extern const RB_Allocator rb_default_allocator;
+
+void *rb_alloc(const RB_Allocator *allocator, size_t size);
+void rb_free(const RB_Allocator *allocator, void *ptr, size_t size);
+
+// Node pool
+
+/* Number of nodes in the first slab when no reserve is given */
+#define RB_POOL_MIN_SLAB 64
+
+/* Slabs double in size up to this many nodes */
+#define RB_POOL_MAX_SLAB 65536
+
+/* A slab is one contiguous chunk of nodes, chained to the previous slab */
+typedef struct RB_Slab_
+{
+    struct RB_Slab_ *next;
+    size_t capacity;
+    RB_Node nodes[];
+} RB_Slab;
+
+/* Nodes are carved from the head slab (bump allocation) and recycled through
+ * an intrusive free list linked by the left pointer, whose last node free_tail
+ * is kept so that two pools can be merged. The trees split from one tree
+ * share its pool, which refs counts */
+struct RB_Pool_
+{
+    RB_Allocator allocator;
+    RB_Slab *slabs;
+    size_t used;
+    RB_Node *free_list;
+    RB_Node *free_tail;
+    size_t refs;
+};
+
+RB_Pool *rb_pool_new(const RB_Allocator *allocator, size_t reserve);
+/* Drop a reference to the pool, releasing its slabs with the last one */
+void rb_pool_destroy(RB_Pool *pool);
+/* Merge two pools of the same allocator, one of which has a single reference,
+ * into the other one, which is returned with that reference added. This
+ * costs the number of slabs plus the room left in one head slab */
+RB_Pool *rb_pool_merge(RB_Pool *a, RB_Pool *b);
+
+RB_Node *rb_node_alloc(RB_Tree *tree);
+void rb_node_free(RB_Tree *tree, RB_Node *node);
+
+// Insertion
+
+/* Insert data below current, which must be the root or a node whose subtree
+ * covers data. Return the new node, or the existing one if data is already in
+ * the tree. *inserted, if not NULL, tells whether a node was created */
+RB_Node *rb_insert_from(RB_Tree *tree, RB_Node *current, T data,
+                        int *inserted);
+
+/* Restore the red black rules after x was linked red under its parent. The
+ * climb stops at a black parent or at the root, so that a subtree hanging
+ * from a black node is fixed without reaching tree->root */
+void rb_insert_fixup(RB_Tree *tree, RB_Node *x);
+
+// Deletion
+
+/* Remove z from the tree like rb_delete, without freeing it. Its fields are
+ * left untouched, so that a reader standing on it can still walk down */
+void rb_unlink(RB_Tree *tree, RB_Node *z);
+
+// Split and join
+
+/* The functions below work on detached subtrees: the root has no parent and
+ * is black, and its black height counts the black nodes on any path down to
+ * nil, nil excluded. They touch neither tree->root nor tree->size, so that
+ * disjoint subtrees of a tree can be handled on several threads */
+
+/* Black height of the subtree of node */
+size_t rb_black_height(RB_Tree *tree, RB_Node *node);
+
+/* Detach the subtree of node from its parent, blackening its root. *height
+ * is its black height, which grows by one when the root was red */
+RB_Node *rb_detach(RB_Tree *tree, RB_Node *node, size_t *height);
+
+/* Join the subtrees l and r of black heights hl and hr around x, whose key
+ * lies between theirs. The shorter subtree hangs, with x, from the spine of
+ * the taller one at the same black height, and the insert fixup repairs x
+ * being red. Return the new root, *height being its black height. This takes
+ * O(|hl - hr| + 1) */
+RB_Node *rb_join_nodes(RB_Tree *tree, RB_Node *l, size_t hl, RB_Node *x,
+                       RB_Node *r, size_t hr, size_t *height);
+
+/* Split the subtree root of black height height into *l, of the keys smaller
+ * than key, and *r, of the greater ones, in O(log n). Return the detached
+ * node of key, or NULL. Both parts still use the nil node of tree, and
+ * handing one to another tree, like rb_adopt does, costs its size */
+RB_Node *rb_split_nodes(RB_Tree *tree, RB_Node *root, size_t height, T key,
+                        RB_Node **l, size_t *hl, RB_Node **r, size_t *hr);
+
+/* Point the nodes of other at the nil node of tree, in O(|other|), and
+ * return the root of other, or the nil node of tree */
+RB_Node *rb_adopt(RB_Tree *tree, RB_Tree *other);
+
+/* Whether the nodes of a and b can be put in one tree: both trees use the
+ * same allocator and either the same pool, no pool, or two pools one of
+ * which no other tree uses */
+int rb_can_share_memory(const RB_Tree *a, const RB_Tree *b);
+
+/* Merge the pools of a and b if they differ, so that either tree can free the
+ * other's nodes */
+void rb_share_memory(RB_Tree *a, RB_Tree *b);
+
+/* Free a tree whose nodes were all given to another one */
+void rb_release(RB_Tree *tree);
+
+// Set operations
+
+/* Smallest black height of both subtrees for which a set operation hands
+ * half of its work to another thread. Such subtrees hold 255 nodes or more,
+ * and several thousands in practice */
+#define RB_SET_GRAIN 8
+
+/* Trees whose sizes differ by this factor or more are combined by a descent
+ * into the larger one for each key of the smaller one, which visits mostly
+ * its upper levels, and beats the recursion relinking m log(n / m) nodes */
+#define RB_SET_SKEW 32
+
+// Lookup
+
+/* Number of descents interleaved by rb_find_batch */
+#define RB_FIND_BATCH_LANES 16
+
+// Bulk building
+
+/* Replace the content of the tree with a balanced tree made of count nodes
+ * given in order as a chain linked by their right pointer */
+void rb_build_from_chain(RB_Tree *tree, RB_Node *head, size_t count);
+
+/* Turn the tree into a chain of its nodes in order, linked by the right
+ * pointer, with right rotations so that no node is moved or allocated. The
+ * tree is left empty */
+RB_Node *rb_flatten(RB_Tree *tree);
+
+// Frozen snapshots
+
+/* Number of keys per cache line. The search prefetches the node this many
+ * positions ahead, which holds its descendants four levels down for ints */
+#define RB_FROZEN_STRIDE (sizeof(T) < 64 ? 64 / sizeof(T) : 1)
+
+/* keys[1..size] holds the keys in Eytzinger order: the children of keys[k]
+ * are keys[2k] and keys[2k + 1]. keys[0] is unused */
+struct RB_Frozen_
+{
+    RB_Allocator allocator;
+    T *keys;
+    size_t size;
+    size_t capacity;
+    unsigned long generation;
+};
+
+/* Keys per block of RB_FrozenBlocks, a block has RB_BLOCK_KEYS + 1 children */
+#define RB_BLOCK_KEYS 16
+
+/* Blocks are aligned on cache lines */
+#define RB_BLOCK_ALIGN 64
+
+/* Count the keys of a block that are less than data */
+typedef unsigned (*RB_BlockRank)(const T *block, T data);
+
+/* keys holds blocks of RB_BLOCK_KEYS keys in the order of an implicit B-tree:
+ * the children of block k are blocks k * (RB_BLOCK_KEYS + 1) + 1 + i for i
+ * in 0..RB_BLOCK_KEYS. The last block is padded with copies of the largest
+ * key. memory is the unaligned allocation holding the blocks */
+struct RB_FrozenBlocks_
+{
+    RB_Allocator allocator;
+    void *memory;
+    T *keys;
+    size_t size;
+    size_t blocks;
+    size_t capacity;
+    unsigned long generation;
+    RB_BlockRank rank;
+    const char *isa;
+};
+
+// Concurrent trees
+
+/* Number of retired nodes that triggers an attempt to free them */
+#define RB_RETIRE_BATCH 64
+
+/* Longest descent of a reader before it assumes it raced with a writer. A
+ * red black tree of n nodes is at most 2 log2(n + 1) deep */
+#define RB_MAX_DEPTH (2 * 8 * sizeof(size_t))
+
+/* Number of times a reader finds a writer at work before yielding */
+#define RB_READER_SPINS 64
+
+/* Node unlinked by a writer, freed once no reader can still reach it */
+typedef struct
+{
+    RB_Node *node;
+    unsigned long epoch;
+} RB_Retired;
+
+/* epoch is the global epoch the reader saw when it started its lookup, 0
+ * between lookups */
+struct RB_Reader_
+{
+    RB_Concurrent *owner;
+    struct RB_Reader_ *next;
+    unsigned long epoch;
+    int in_use;
+};
+
+/* Writers hold lock and make sequence odd while they change the tree. Readers
+ * retry a lookup during which sequence changed */
+struct RB_Concurrent_
+{
+    RB_Tree *tree;
+    pthread_mutex_t lock;
+    unsigned long sequence;
+    unsigned long epoch;
+    RB_Reader *readers;
+    RB_Retired *retired;
+    size_t retired_count;
+    size_t retired_capacity;
+};
+
+// Sharded trees
+
+/* Size of a cache line, kept between the locks of two shards */
+#define RB_CACHE_LINE 64
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    RB_Tree *tree;
+    char padding[RB_CACHE_LINE];
+} RB_Shard;
+
+/* Shard i holds the keys in [bounds[i - 1], bounds[i]), the first and last
+ * shards being open ended, so that there are count - 1 bounds */
+struct RB_Sharded_
+{
+    RB_Allocator allocator;
+    T *bounds;
+    RB_Shard *shards;
+    size_t count;
+};
+
+// Persistent trees
+
+/* Node of a persistent tree, without a parent so that versions can share
+ * subtrees. refs counts the versions and the nodes pointing to it. A node
+ * with a single reference belongs to the version being written and may be
+ * changed in place, any other one is copied first */
+typedef struct RB_PNode_
+{
+    struct RB_PNode_ *left;
+    struct RB_PNode_ *right;
+    size_t refs;
+    RB_Color color;
+    T data;
+} RB_PNode;
+
+/* The writer holds lock for the whole of an update. Before changing anything
+ * it stocks spares with enough nodes for every copy the update may need, so
+ * that an update either fails untouched or completes. Deleted nodes refill
+ * spares up to what one deletion needs and are freed beyond */
+struct RB_Persistent_
+{
+    RB_Allocator allocator;
+    pthread_mutex_t lock;
+    RB_PNode *root;
+    size_t size;
+    RB_PNode *spares;
+    size_t spare_count;
+};
+
+struct RB_Snapshot_
+{
+    RB_Allocator allocator;
+    RB_PNode *root;
+    size_t size;
+};
+
+// Binary images
+
+#define RB_IMAGE_MAGIC "RBTREE\0\0"
+#define RB_IMAGE_VERSION 1
+#define RB_IMAGE_BYTE_ORDER 0x01020304u
+#define RB_IMAGE_CHUNK 1024
+
+/* Start of an image, followed by count keys in ascending order. Its 32 bytes
+ * keep the keys of a mapped image aligned. Every field is in the byte order
+ * of the machine that wrote it, which byte_order tells */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t key_size;
+    uint32_t flags;
+    uint64_t count;
+} RB_ImageHeader;
+
+struct RB_Mapped_
+{
+    void *base;
+    size_t length;
+    const T *keys;
+    size_t size;
+};
+
 void rb_rotate_left(RB_Tree *tree, RB_Node *x);
 void rb_rotate_right(RB_Tree *tree, RB_Node *x);
 
@@ -0,0 +1,121 @@
+#include "../rb_tree.h"
+
+static RB_Node *rb_minimum(RB_Tree *tree, RB_Node *node)
+{
+    while (node->left != &tree->nil)
+    {
+        node = node->left;
+    }
+    return node;
+}
+
+static RB_Node *rb_maximum(RB_Tree *tree, RB_Node *node)
+{
+    while (node->right != &tree->nil)
+    {
+        node = node->right;
+    }
+    return node;
+}
+
+RB_Node *rb_first(RB_Tree *tree)
+{
+    if (!tree || tree->root == &tree->nil)
+    {
+        return NULL;
+    }
+    return rb_minimum(tree, tree->root);
+}
+
+RB_Node *rb_last(RB_Tree *tree)
+{
+    if (!tree || tree->root == &tree->nil)
+    {
+        return NULL;
+    }
+    return rb_maximum(tree, tree->root);
+}
+
+RB_Node *rb_next(RB_Tree *tree, RB_Node *node)
+{
+    if (!tree || !node || node == &tree->nil)
+    {
+        return NULL;
+    }
+
+    if (node->right != &tree->nil)
+    {
+        return rb_minimum(tree, node->right);
+    }
+
+    // Climb until we come from a left subtree
+    RB_Node *parent = rb_parent(node);
+    while (parent && node == parent->right)
+    {
+        node = parent;
+        parent = rb_parent(parent);
+    }
+    return parent;
+}
+
+RB_Node *rb_prev(RB_Tree *tree, RB_Node *node)
+{
+    if (!tree || !node || node == &tree->nil)
+    {
+        return NULL;
+    }
+
+    if (node->left != &tree->nil)
+    {
+        return rb_maximum(tree, node->left);
+    }
+
+    // Climb until we come from a right subtree
+    RB_Node *parent = rb_parent(node);
+    while (parent && node == parent->left)
+    {
+        node = parent;
+        parent = rb_parent(parent);
+    }
+    return parent;
+}
+
+void rb_cursor_first(RB_Cursor *cursor, RB_Tree *tree)
+{
+    if (!cursor)
+    {
+        return;
+    }
+    cursor->tree = tree;
+    cursor->node = rb_first(tree);
+}
+
+void rb_cursor_last(RB_Cursor *cursor, RB_Tree *tree)
+{
+    if (!cursor)
+    {
+        return;
+    }
+    cursor->tree = tree;
+    cursor->node = rb_last(tree);
+}
+
+RB_Node *rb_cursor_next(RB_Cursor *cursor)
+{
+    if (!cursor)
+    {
+        return NULL;
+    }
+    cursor->node = rb_next(cursor->tree, cursor->node);
+    return cursor->node;
+}
+
+RB_Node *rb_cursor_prev(RB_Cursor *cursor)
+{
+    if (!cursor)
+    {
+        return NULL;
+    }
+    cursor->node = rb_prev(cursor->tree, cursor->node);
+    return cursor->node;
+}
@@ -1,8 +1,13 @@
-#include "../rb_tree.h"
+#include "rb_tree_internal.h"
 
-RB_Tree *rb_tree_new(void)
+RB_Tree *rb_tree_new_with_allocator(const RB_Allocator *allocator)
 {
-    RB_Tree *tree = malloc(sizeof(RB_Tree));
+    if (!allocator)
+    {
+        allocator = &rb_default_allocator;
+    }
+
+    RB_Tree *tree = rb_alloc(allocator, sizeof(RB_Tree));
     if (!tree)
     {
         return NULL;
@@ -10,11 +15,49 @@ RB_Tree *rb_tree_new(void)
 
     tree->nil.left = &tree->nil;
     tree->nil.right = &tree->nil;
-    tree->nil.parent = &tree->nil;
-    tree->nil.color = BLACK;
+    rb_set_parent_color(&tree->nil, &tree->nil, BLACK);
     tree->nil.data = 0;
+#ifdef RB_ORDER_STATISTICS
+    tree->nil.size = 0;
+#endif // RB_ORDER_STATISTICS
 
     tree->root = &tree->nil;
+    tree->size = 0;
+    tree->generation = 0;
+    tree->allocator = *allocator;
+    tree->pool = NULL;
+#ifdef RB_STATS
+    tree->stats = (RB_Stats){ 0 };
+#endif // RB_STATS
+
+    return tree;
+}
+
+RB_Tree *rb_tree_new(void)
+{
+    return rb_tree_new_with_allocator(NULL);
+}
+
+RB_Tree *rb_tree_new_with_pool(size_t reserve)
+{
+    return rb_tree_new_with_pool_allocator(NULL, reserve);
+}
+
+RB_Tree *rb_tree_new_with_pool_allocator(const RB_Allocator *allocator,
+                                         size_t reserve)
+{
+    RB_Tree *tree = rb_tree_new_with_allocator(allocator);
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    tree->pool = rb_pool_new(&tree->allocator, reserve);
+    if (!tree->pool)
+    {
+        rb_free(&tree->allocator, tree, sizeof(RB_Tree));
+        return NULL;
+    }
 
     return tree;
 }
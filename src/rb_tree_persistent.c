@@ -0,0 +1,616 @@
+#include "rb_tree_internal.h"
+
+// Reference counting
+
+static void rb_pnode_retain(RB_PNode *node)
+{
+    if (node)
+    {
+        __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* Drop a reference, freeing the nodes that no version uses anymore */
+static void rb_pnode_release(const RB_Allocator *allocator, RB_PNode *node)
+{
+    while (node && __atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        // Recursion on the left only, so that the stack stays within the
+        // height of the tree
+        RB_PNode *right = node->right;
+        rb_pnode_release(allocator, node->left);
+        rb_free(allocator, node, sizeof(RB_PNode));
+        node = right;
+    }
+}
+
+static int rb_pnode_is_black(const RB_PNode *node)
+{
+    return !node || node->color == BLACK;
+}
+
+// Spare nodes
+
+/* Make sure that count nodes can be taken without allocating */
+static int rb_spares_reserve(RB_Persistent *tree, size_t count)
+{
+    while (tree->spare_count < count)
+    {
+        RB_PNode *node = rb_alloc(&tree->allocator, sizeof(RB_PNode));
+        if (!node)
+        {
+            fprintf(stderr, "insufficient memory (rb_persistent)\n");
+            return -1;
+        }
+        node->left = tree->spares;
+        tree->spares = node;
+        tree->spare_count++;
+    }
+    return 0;
+}
+
+/* Number of spares a deletion from a tree of size nodes may need: the path
+ * down to the successor, and per level a sibling and its two children, plus
+ * a red sibling rotated once and the recolored child. A red black tree of n
+ * nodes is at most 2 log2(n + 1) deep */
+static size_t rb_spares_for_delete(size_t size)
+{
+    size_t height = 0;
+    for (size_t n = size + 1; n; n >>= 1)
+    {
+        height += 2;
+    }
+    return 4 * height + 4;
+}
+
+/* Keep a node that left the tree as a spare, unless the spares already cover
+ * a deletion, so that they never grow past what one update needs */
+static void rb_spares_put(RB_Persistent *tree, RB_PNode *node)
+{
+    if (tree->spare_count >= rb_spares_for_delete(tree->size))
+    {
+        rb_free(&tree->allocator, node, sizeof(RB_PNode));
+        return;
+    }
+    node->left = tree->spares;
+    tree->spares = node;
+    tree->spare_count++;
+}
+
+static RB_PNode *rb_spares_take(RB_Persistent *tree)
+{
+    RB_PNode *node = tree->spares;
+    tree->spares = node->left;
+    tree->spare_count--;
+    return node;
+}
+
+/* Return the node in *slot, first replacing it by a copy when another version
+ * shares it. The parent holding slot must already belong to the writer */
+static RB_PNode *rb_pnode_own(RB_Persistent *tree, RB_PNode **slot)
+{
+    RB_PNode *node = *slot;
+    if (__atomic_load_n(&node->refs, __ATOMIC_ACQUIRE) == 1)
+    {
+        return node;
+    }
+
+    RB_PNode *copy = rb_spares_take(tree);
+    copy->left = node->left;
+    copy->right = node->right;
+    copy->refs = 1;
+    copy->color = node->color;
+    copy->data = node->data;
+    rb_pnode_retain(copy->left);
+    rb_pnode_retain(copy->right);
+    *slot = copy;
+    rb_pnode_release(&tree->allocator, node);
+    return copy;
+}
+
+/* Depth of data, or of the empty place where it would go, with *found
+ * telling which */
+static size_t rb_pnode_depth(const RB_PNode *node, T data, int *found)
+{
+    size_t depth = 0;
+    *found = 0;
+    while (node)
+    {
+        int cmp = compCMP(data, node->data);
+        if (cmp == 0)
+        {
+            *found = 1;
+            break;
+        }
+        depth++;
+        node = cmp < 0 ? node->left : node->right;
+    }
+    return depth;
+}
+
+// Insertion
+
+/* Fix a red child with a red child below the black node in *slot, on the
+ * given side, by making the middle one of the three the red parent of the
+ * two others (Okasaki). All three already belong to the writer */
+static void rb_pbalance(RB_PNode **slot, int left)
+{
+    RB_PNode *z = *slot;
+    if (z->color != BLACK)
+    {
+        return;
+    }
+
+    RB_PNode *x, *y;
+    if (left)
+    {
+        RB_PNode *child = z->left;
+        if (rb_pnode_is_black(child))
+        {
+            return;
+        }
+        if (!rb_pnode_is_black(child->left))
+        {
+            y = child;
+            x = child->left;
+            z->left = y->right;
+            y->right = z;
+        }
+        else if (!rb_pnode_is_black(child->right))
+        {
+            x = child;
+            y = child->right;
+            x->right = y->left;
+            z->left = y->right;
+            y->left = x;
+            y->right = z;
+        }
+        else
+        {
+            return;
+        }
+    }
+    else
+    {
+        RB_PNode *child = z->right;
+        if (rb_pnode_is_black(child))
+        {
+            return;
+        }
+        if (!rb_pnode_is_black(child->right))
+        {
+            y = child;
+            x = child->right;
+            z->right = y->left;
+            y->left = z;
+        }
+        else if (!rb_pnode_is_black(child->left))
+        {
+            x = child;
+            y = child->left;
+            x->left = y->right;
+            z->right = y->left;
+            y->right = x;
+            y->left = z;
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    y->color = RED;
+    x->color = BLACK;
+    z->color = BLACK;
+    *slot = y;
+}
+
+static void rb_pinsert(RB_Persistent *tree, RB_PNode **slot, T data)
+{
+    if (!*slot)
+    {
+        RB_PNode *node = rb_spares_take(tree);
+        node->left = NULL;
+        node->right = NULL;
+        node->refs = 1;
+        node->color = RED;
+        node->data = data;
+        *slot = node;
+        return;
+    }
+
+    RB_PNode *node = rb_pnode_own(tree, slot);
+    int left = compCMP(data, node->data) < 0;
+    rb_pinsert(tree, left ? &node->left : &node->right, data);
+    rb_pbalance(slot, left);
+}
+
+int rb_persistent_insert(RB_Persistent *tree, T data)
+{
+    if (!tree)
+    {
+        return -1;
+    }
+
+    int found;
+    pthread_mutex_lock(&tree->lock);
+    size_t depth = rb_pnode_depth(tree->root, data, &found);
+    if (found || rb_spares_reserve(tree, depth + 1) != 0)
+    {
+        pthread_mutex_unlock(&tree->lock);
+        return found ? 0 : -1;
+    }
+
+    // The root is the version's own reference, owned like any other slot
+    rb_pinsert(tree, &tree->root, data);
+    tree->root->color = BLACK;
+    tree->size++;
+    pthread_mutex_unlock(&tree->lock);
+    return 1;
+}
+
+// Deletion
+
+/* The subtree on the left of the node in *slot lost one black node: borrow
+ * from the right side, or pass the loss up through *shrunk */
+static void rb_pfix_left(RB_Persistent *tree, RB_PNode **slot, int *shrunk)
+{
+    RB_PNode *node = *slot;
+    RB_PNode *sibling = rb_pnode_own(tree, &node->right);
+    *shrunk = 0;
+
+    if (sibling->color == RED)
+    {
+        // Rotate so that the sibling is black, node turning red ends the loss
+        node->right = sibling->left;
+        sibling->left = node;
+        sibling->color = BLACK;
+        node->color = RED;
+        *slot = sibling;
+        rb_pfix_left(tree, &sibling->left, shrunk);
+        return;
+    }
+
+    if (rb_pnode_is_black(sibling->left) && rb_pnode_is_black(sibling->right))
+    {
+        sibling->color = RED;
+        *shrunk = node->color == BLACK;
+        node->color = BLACK;
+        return;
+    }
+
+    if (rb_pnode_is_black(sibling->right))
+    {
+        RB_PNode *nephew = rb_pnode_own(tree, &sibling->left);
+        sibling->left = nephew->right;
+        nephew->right = sibling;
+        nephew->color = BLACK;
+        sibling->color = RED;
+        node->right = nephew;
+        sibling = nephew;
+    }
+
+    RB_PNode *nephew = rb_pnode_own(tree, &sibling->right);
+    node->right = sibling->left;
+    sibling->left = node;
+    sibling->color = node->color;
+    node->color = BLACK;
+    nephew->color = BLACK;
+    *slot = sibling;
+}
+
+/* Mirror of rb_pfix_left */
+static void rb_pfix_right(RB_Persistent *tree, RB_PNode **slot, int *shrunk)
+{
+    RB_PNode *node = *slot;
+    RB_PNode *sibling = rb_pnode_own(tree, &node->left);
+    *shrunk = 0;
+
+    if (sibling->color == RED)
+    {
+        node->left = sibling->right;
+        sibling->right = node;
+        sibling->color = BLACK;
+        node->color = RED;
+        *slot = sibling;
+        rb_pfix_right(tree, &sibling->right, shrunk);
+        return;
+    }
+
+    if (rb_pnode_is_black(sibling->left) && rb_pnode_is_black(sibling->right))
+    {
+        sibling->color = RED;
+        *shrunk = node->color == BLACK;
+        node->color = BLACK;
+        return;
+    }
+
+    if (rb_pnode_is_black(sibling->left))
+    {
+        RB_PNode *nephew = rb_pnode_own(tree, &sibling->right);
+        sibling->right = nephew->left;
+        nephew->left = sibling;
+        nephew->color = BLACK;
+        sibling->color = RED;
+        node->left = nephew;
+        sibling = nephew;
+    }
+
+    RB_PNode *nephew = rb_pnode_own(tree, &sibling->left);
+    node->left = sibling->right;
+    sibling->right = node;
+    sibling->color = node->color;
+    node->color = BLACK;
+    nephew->color = BLACK;
+    *slot = sibling;
+}
+
+/* Remove data, which is in the subtree of *slot. *shrunk tells whether the
+ * subtree lost one black node on every path */
+static void rb_pdelete(RB_Persistent *tree, RB_PNode **slot, T data,
+                       int *shrunk)
+{
+    RB_PNode *node = rb_pnode_own(tree, slot);
+    int cmp = compCMP(data, node->data);
+
+    // A node with two children takes the data of its successor, which is
+    // then removed from the right subtree
+    if (cmp == 0 && node->left && node->right)
+    {
+        RB_PNode *successor = node->right;
+        while (successor->left)
+        {
+            successor = successor->left;
+        }
+        node->data = successor->data;
+        data = successor->data;
+        cmp = 1;
+    }
+
+    if (cmp == 0)
+    {
+        RB_PNode **child = node->left ? &node->left : &node->right;
+        *shrunk = 0;
+        if (*child)
+        {
+            // The only child of a node is a red leaf
+            rb_pnode_own(tree, child)->color = BLACK;
+        }
+        else
+        {
+            *shrunk = node->color == BLACK;
+        }
+
+        // The child reference moves to the parent, node is ours alone
+        *slot = *child;
+        rb_spares_put(tree, node);
+        return;
+    }
+
+    if (cmp < 0)
+    {
+        rb_pdelete(tree, &node->left, data, shrunk);
+        if (*shrunk)
+        {
+            rb_pfix_left(tree, slot, shrunk);
+        }
+    }
+    else
+    {
+        rb_pdelete(tree, &node->right, data, shrunk);
+        if (*shrunk)
+        {
+            rb_pfix_right(tree, slot, shrunk);
+        }
+    }
+}
+
+int rb_persistent_delete(RB_Persistent *tree, T data)
+{
+    if (!tree)
+    {
+        return -1;
+    }
+
+    int found;
+    pthread_mutex_lock(&tree->lock);
+    rb_pnode_depth(tree->root, data, &found);
+    if (!found)
+    {
+        pthread_mutex_unlock(&tree->lock);
+        return 0;
+    }
+
+    if (rb_spares_reserve(tree, rb_spares_for_delete(tree->size)) != 0)
+    {
+        pthread_mutex_unlock(&tree->lock);
+        return -1;
+    }
+
+    int shrunk;
+    rb_pdelete(tree, &tree->root, data, &shrunk);
+    if (tree->root)
+    {
+        tree->root->color = BLACK;
+    }
+    tree->size--;
+    pthread_mutex_unlock(&tree->lock);
+    return 1;
+}
+
+// Lookups
+
+static const RB_PNode *rb_pnode_find(const RB_PNode *node, T data)
+{
+    while (node)
+    {
+        int cmp = compCMP(data, node->data);
+        if (cmp == 0)
+        {
+            return node;
+        }
+        node = cmp < 0 ? node->left : node->right;
+    }
+    return NULL;
+}
+
+int rb_persistent_find(RB_Persistent *tree, T data, T *out)
+{
+    if (!tree)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tree->lock);
+    const RB_PNode *node = rb_pnode_find(tree->root, data);
+    if (node && out)
+    {
+        *out = node->data;
+    }
+    pthread_mutex_unlock(&tree->lock);
+    return node != NULL;
+}
+
+size_t rb_persistent_size(RB_Persistent *tree)
+{
+    if (!tree)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&tree->lock);
+    size_t size = tree->size;
+    pthread_mutex_unlock(&tree->lock);
+    return size;
+}
+
+// Versions
+
+RB_Persistent *rb_persistent_new(void)
+{
+    RB_Persistent *tree =
+        rb_alloc(&rb_default_allocator, sizeof(RB_Persistent));
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_persistent_new)\n");
+        return NULL;
+    }
+    if (pthread_mutex_init(&tree->lock, NULL) != 0)
+    {
+        rb_free(&rb_default_allocator, tree, sizeof(RB_Persistent));
+        return NULL;
+    }
+
+    tree->allocator = rb_default_allocator;
+    tree->root = NULL;
+    tree->size = 0;
+    tree->spares = NULL;
+    tree->spare_count = 0;
+    return tree;
+}
+
+void rb_persistent_destroy(RB_Persistent *tree)
+{
+    if (!tree)
+    {
+        return;
+    }
+
+    RB_Allocator allocator = tree->allocator;
+    rb_pnode_release(&allocator, tree->root);
+    while (tree->spares)
+    {
+        RB_PNode *next = tree->spares->left;
+        rb_free(&allocator, tree->spares, sizeof(RB_PNode));
+        tree->spares = next;
+    }
+    pthread_mutex_destroy(&tree->lock);
+    rb_free(&allocator, tree, sizeof(RB_Persistent));
+}
+
+RB_Snapshot *rb_persistent_snapshot(RB_Persistent *tree)
+{
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Snapshot *snapshot = rb_alloc(&tree->allocator, sizeof(RB_Snapshot));
+    if (!snapshot)
+    {
+        fprintf(stderr, "insufficient memory (rb_persistent_snapshot)\n");
+        return NULL;
+    }
+
+    snapshot->allocator = tree->allocator;
+    pthread_mutex_lock(&tree->lock);
+    snapshot->root = tree->root;
+    snapshot->size = tree->size;
+    rb_pnode_retain(snapshot->root);
+    pthread_mutex_unlock(&tree->lock);
+    return snapshot;
+}
+
+int rb_snapshot_find(const RB_Snapshot *snapshot, T data, T *out)
+{
+    if (!snapshot)
+    {
+        return 0;
+    }
+
+    const RB_PNode *node = rb_pnode_find(snapshot->root, data);
+    if (node && out)
+    {
+        *out = node->data;
+    }
+    return node != NULL;
+}
+
+size_t rb_snapshot_size(const RB_Snapshot *snapshot)
+{
+    return snapshot ? snapshot->size : 0;
+}
+
+size_t rb_snapshot_visit(const RB_Snapshot *snapshot, RB_DataVisit visit,
+                         void *ctx)
+{
+    const RB_PNode *stack[RB_MAX_DEPTH];
+    size_t depth = 0;
+    size_t count = 0;
+
+    if (!snapshot || !visit)
+    {
+        return 0;
+    }
+
+    // Without parents, the way back up is kept on a stack as deep as the tree
+    const RB_PNode *node = snapshot->root;
+    while (node || depth > 0)
+    {
+        while (node)
+        {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        node = stack[--depth];
+        count++;
+        if (visit(node->data, ctx))
+        {
+            break;
+        }
+        node = node->right;
+    }
+    return count;
+}
+
+void rb_snapshot_release(RB_Snapshot *snapshot)
+{
+    if (!snapshot)
+    {
+        return;
+    }
+
+    RB_Allocator allocator = snapshot->allocator;
+    rb_pnode_release(&allocator, snapshot->root);
+    rb_free(&allocator, snapshot, sizeof(RB_Snapshot));
+}
@@ -0,0 +1,175 @@
+#include "rb_tree_internal.h"
+
+static RB_Slab *rb_slab_new(const RB_Allocator *allocator, size_t capacity)
+{
+    // A reserve can come from a caller or a file, so its size may not fit
+    if (capacity > (SIZE_MAX - sizeof(RB_Slab)) / sizeof(RB_Node))
+    {
+        return NULL;
+    }
+
+    RB_Slab *slab =
+        rb_alloc(allocator, sizeof(RB_Slab) + capacity * sizeof(RB_Node));
+    if (!slab)
+    {
+        return NULL;
+    }
+
+    slab->next = NULL;
+    slab->capacity = capacity;
+    return slab;
+}
+
+RB_Pool *rb_pool_new(const RB_Allocator *allocator, size_t reserve)
+{
+    RB_Pool *pool = rb_alloc(allocator, sizeof(RB_Pool));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pool->allocator = *allocator;
+    pool->slabs = rb_slab_new(allocator, reserve ? reserve : RB_POOL_MIN_SLAB);
+    if (!pool->slabs)
+    {
+        rb_free(allocator, pool, sizeof(RB_Pool));
+        return NULL;
+    }
+    pool->used = 0;
+    pool->free_list = NULL;
+    pool->free_tail = NULL;
+    pool->refs = 1;
+
+    return pool;
+}
+
+void rb_pool_destroy(RB_Pool *pool)
+{
+    if (!pool || --pool->refs > 0)
+    {
+        return;
+    }
+
+    RB_Allocator allocator = pool->allocator;
+    RB_Slab *slab = pool->slabs;
+    while (slab)
+    {
+        RB_Slab *next = slab->next;
+        rb_free(&allocator, slab,
+                sizeof(RB_Slab) + slab->capacity * sizeof(RB_Node));
+        slab = next;
+    }
+    rb_free(&allocator, pool, sizeof(RB_Pool));
+}
+
+/* Put node on the free list of the pool */
+static void rb_pool_push(RB_Pool *pool, RB_Node *node)
+{
+    if (!pool->free_list)
+    {
+        pool->free_tail = node;
+    }
+    node->left = pool->free_list;
+    pool->free_list = node;
+}
+
+RB_Pool *rb_pool_merge(RB_Pool *a, RB_Pool *b)
+{
+    // The pool of a single tree is emptied into the other one
+    RB_Pool *pool = b->refs == 1 ? a : b;
+    RB_Pool *other = pool == a ? b : a;
+
+    if (other->free_list)
+    {
+        other->free_tail->left = pool->free_list;
+        if (!pool->free_list)
+        {
+            pool->free_tail = other->free_tail;
+        }
+        pool->free_list = other->free_list;
+    }
+
+    // The head slab with the most room keeps serving new nodes, and the room
+    // left in the other one goes to the free list
+    RB_Slab *keep = pool->slabs;
+    size_t keep_used = pool->used;
+    RB_Slab *drop = other->slabs;
+    size_t drop_used = other->used;
+    if (drop->capacity - drop_used > keep->capacity - keep_used)
+    {
+        keep = other->slabs;
+        keep_used = other->used;
+        drop = pool->slabs;
+        drop_used = pool->used;
+    }
+    for (size_t i = drop_used; i < drop->capacity; i++)
+    {
+        rb_pool_push(pool, &drop->nodes[i]);
+    }
+
+    // Chain the slabs as keep, the chain of drop, then the rest of keep's
+    RB_Slab *last = drop;
+    while (last->next)
+    {
+        last = last->next;
+    }
+    last->next = keep->next;
+    keep->next = drop;
+    pool->slabs = keep;
+    pool->used = keep_used;
+
+    // The tree of other now holds a reference to pool
+    pool->refs++;
+    rb_free(&other->allocator, other, sizeof(RB_Pool));
+    return pool;
+}
+
+static RB_Node *rb_pool_alloc(RB_Pool *pool)
+{
+    RB_Node *node = pool->free_list;
+    if (node)
+    {
+        pool->free_list = node->left;
+        return node;
+    }
+
+    if (pool->used == pool->slabs->capacity)
+    {
+        // Grow geometrically so that the number of slabs stays logarithmic
+        size_t capacity = pool->slabs->capacity * 2;
+        if (capacity > RB_POOL_MAX_SLAB)
+        {
+            capacity = RB_POOL_MAX_SLAB;
+        }
+
+        RB_Slab *slab = rb_slab_new(&pool->allocator, capacity);
+        if (!slab)
+        {
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->used = 0;
+    }
+
+    return &pool->slabs->nodes[pool->used++];
+}
+
+RB_Node *rb_node_alloc(RB_Tree *tree)
+{
+    if (tree->pool)
+    {
+        return rb_pool_alloc(tree->pool);
+    }
+    return rb_alloc(&tree->allocator, sizeof(RB_Node));
+}
+
+void rb_node_free(RB_Tree *tree, RB_Node *node)
+{
+    if (tree->pool)
+    {
+        rb_pool_push(tree->pool, node);
+        return;
+    }
+    rb_free(&tree->allocator, node, sizeof(RB_Node));
+}
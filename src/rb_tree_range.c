@@ -0,0 +1,112 @@
+#include "rb_tree_internal.h"
+
+RB_Node *rb_lower_bound(RB_Tree *tree, T data)
+{
+    RB_Node *result = NULL;
+
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Node *current = tree->root;
+    size_t depth = 0;
+    while (current != &tree->nil)
+    {
+        depth++;
+        if (compCMP(current->data, data) >= 0)
+        {
+            result = current;
+            current = current->left;
+        }
+        else
+        {
+            current = current->right;
+        }
+    }
+    RB_STAT_DESCENT(tree, depth);
+    return result;
+}
+
+RB_Node *rb_upper_bound(RB_Tree *tree, T data)
+{
+    RB_Node *result = NULL;
+
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Node *current = tree->root;
+    size_t depth = 0;
+    while (current != &tree->nil)
+    {
+        depth++;
+        if (compCMP(current->data, data) > 0)
+        {
+            result = current;
+            current = current->left;
+        }
+        else
+        {
+            current = current->right;
+        }
+    }
+    RB_STAT_DESCENT(tree, depth);
+    return result;
+}
+
+RB_Node *rb_floor(RB_Tree *tree, T data)
+{
+    RB_Node *result = NULL;
+
+    if (!tree)
+    {
+        return NULL;
+    }
+
+    RB_Node *current = tree->root;
+    size_t depth = 0;
+    while (current != &tree->nil)
+    {
+        depth++;
+        if (compCMP(current->data, data) <= 0)
+        {
+            result = current;
+            current = current->right;
+        }
+        else
+        {
+            current = current->left;
+        }
+    }
+    RB_STAT_DESCENT(tree, depth);
+    return result;
+}
+
+RB_Node *rb_ceil(RB_Tree *tree, T data)
+{
+    return rb_lower_bound(tree, data);
+}
+
+size_t rb_range(RB_Tree *tree, T lo, T hi, RB_Visit visit, void *ctx)
+{
+    size_t count = 0;
+
+    if (!tree || !visit)
+    {
+        return 0;
+    }
+
+    // One descent to the first node, then stream through the successors
+    for (RB_Node *node = rb_lower_bound(tree, lo);
+         node && compCMP(node->data, hi) < 0; node = rb_next(tree, node))
+    {
+        count++;
+        if (visit(node, ctx))
+        {
+            break;
+        }
+    }
+    return count;
+}
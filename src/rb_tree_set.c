@@ -0,0 +1,453 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <unistd.h>
+
+#include "rb_tree_internal.h"
+
+// Each step splits the subtree b by the key of the root of a, recurses on the
+// two halves and joins the results around that root, or without it. The
+// first half may run on another thread: the halves share no node, and the
+// split and join functions stay within their subtree. Nodes that leave the
+// result are only chained during the recursion, then freed by the calling
+// thread, as node pools are not thread safe. Lopsided pairs of trees skip the
+// recursion (rb_set_lopsided)
+
+typedef enum
+{
+    RB_UNION,
+    RB_INTERSECT,
+    RB_DIFFERENCE
+} RB_SetOp;
+
+/* One step of a set operation on the detached subtrees a and b, whose
+ * result is result of black height height. Discarded subtrees are chained
+ * from discarded to last through the parent pointer of their root */
+typedef struct
+{
+    RB_Tree *tree;
+    RB_SetOp op;
+    RB_Node *a;
+    size_t ha;
+    RB_Node *b;
+    size_t hb;
+    unsigned threads;
+    RB_Node *result;
+    size_t height;
+    RB_Node *discarded;
+    RB_Node *last;
+} RB_SetTask;
+
+/* Chain a detached subtree to the discarded ones */
+static void rb_discard(RB_SetTask *task, RB_Node *node)
+{
+    if (node == &task->tree->nil)
+    {
+        return;
+    }
+    rb_set_parent(node, NULL);
+    if (task->last)
+    {
+        rb_set_parent(task->last, node);
+    }
+    else
+    {
+        task->discarded = node;
+    }
+    task->last = node;
+}
+
+/* Discard a node whose children were taken */
+static void rb_discard_node(RB_SetTask *task, RB_Node *node)
+{
+    if (node)
+    {
+        node->left = node->right = &task->tree->nil;
+        rb_discard(task, node);
+    }
+}
+
+/* Move the discarded subtrees of from after those of task */
+static void rb_discard_all(RB_SetTask *task, RB_SetTask *from)
+{
+    if (!from->discarded)
+    {
+        return;
+    }
+    if (task->last)
+    {
+        rb_set_parent(task->last, from->discarded);
+    }
+    else
+    {
+        task->discarded = from->discarded;
+    }
+    task->last = from->last;
+}
+
+/* Free the discarded subtrees like rb_tree_destroy, and count their nodes */
+static size_t rb_free_discarded(RB_Tree *tree, RB_Node *list)
+{
+    size_t count = 0;
+    while (list)
+    {
+        RB_Node *node = list;
+        list = rb_parent(list);
+        while (node != &tree->nil)
+        {
+            RB_Node *left = node->left;
+            if (left != &tree->nil)
+            {
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            }
+            else
+            {
+                RB_Node *right = node->right;
+                rb_node_free(tree, node);
+                count++;
+                node = right;
+            }
+        }
+    }
+    return count;
+}
+
+/* Join l and r, whose keys are all smaller than those of r, without pivot:
+ * the largest node of l is taken out to serve as one */
+static RB_Node *rb_concat_nodes(RB_Tree *tree, RB_Node *l, size_t hl,
+                                RB_Node *r, size_t hr, size_t *height)
+{
+    RB_Node *nil = &tree->nil;
+    if (l == nil || r == nil)
+    {
+        *height = l == nil ? hr : hl;
+        return l == nil ? r : l;
+    }
+
+    RB_Node *last = l;
+    while (last->right != nil)
+    {
+        last = last->right;
+    }
+
+    // The largest node has no right child, so it comes out in O(1) when it
+    // is the root, is red or has a red left child to take its place. Only a
+    // black leaf needs a split
+    RB_Node *rest;
+    size_t hrest;
+    RB_Node *child = last->left;
+    if (last == l)
+    {
+        hrest = hl - 1;
+        rest = rb_detach(tree, child, &hrest);
+    }
+    else if (rb_color(last) == RED || child != nil)
+    {
+        RB_Node *parent = rb_parent(last);
+        parent->right = child;
+        if (child != nil)
+        {
+            rb_set_parent_color(child, parent, BLACK);
+        }
+#ifdef RB_ORDER_STATISTICS
+        for (RB_Node *p = parent; p; p = rb_parent(p))
+        {
+            p->size--;
+        }
+#endif // RB_ORDER_STATISTICS
+        rest = l;
+        hrest = hl;
+    }
+    else
+    {
+        RB_Node *empty;
+        size_t hempty;
+        rb_split_nodes(tree, l, hl, last->data, &rest, &hrest, &empty,
+                       &hempty);
+    }
+    return rb_join_nodes(tree, rest, hrest, last, r, hr, height);
+}
+
+static void rb_set_run(RB_SetTask *task);
+
+static void *rb_set_thread(void *arg)
+{
+    rb_set_run(arg);
+    return NULL;
+}
+
+static void rb_set_run(RB_SetTask *task)
+{
+    RB_Tree *tree = task->tree;
+    RB_Node *nil = &tree->nil;
+    RB_Node *a = task->a;
+    RB_Node *b = task->b;
+
+    if (a == nil || b == nil)
+    {
+        // Union keeps both, intersection neither and difference a
+        int keep_a = task->op != RB_INTERSECT;
+        int keep_b = task->op == RB_UNION;
+        task->result = keep_a && a != nil ? a : keep_b ? b : nil;
+        task->height = task->result == nil ? 0
+                     : task->result == a   ? task->ha
+                                           : task->hb;
+        rb_discard(task, keep_a ? nil : a);
+        rb_discard(task, keep_b ? nil : b);
+        return;
+    }
+
+    // Split b by the key of the root of a, then run on each side
+    size_t hl = task->ha - 1;
+    size_t hr = hl;
+    RB_Node *al = rb_detach(tree, a->left, &hl);
+    RB_Node *ar = rb_detach(tree, a->right, &hr);
+    RB_Node *bl, *br;
+    size_t hbl, hbr;
+    RB_Node *match =
+        rb_split_nodes(tree, b, task->hb, a->data, &bl, &hbl, &br, &hbr);
+
+    RB_SetTask halves[2];
+    for (int i = 0; i < 2; i++)
+    {
+        RB_SetTask *half = &halves[i];
+        half->tree = tree;
+        half->op = task->op;
+        half->a = i ? ar : al;
+        half->ha = i ? hr : hl;
+        half->b = i ? br : bl;
+        half->hb = i ? hbr : hbl;
+        half->discarded = half->last = NULL;
+    }
+    halves[0].threads = task->threads / 2;
+    halves[1].threads = task->threads - halves[0].threads;
+
+    // The left half goes to another thread while threads remain and both
+    // subtrees are large, and runs here when none can be started
+    size_t smaller = task->ha < task->hb ? task->ha : task->hb;
+    pthread_t thread;
+    int spawned = task->threads > 1 && smaller >= RB_SET_GRAIN
+               && pthread_create(&thread, NULL, rb_set_thread, &halves[0])
+                      == 0;
+    if (!spawned)
+    {
+        rb_set_run(&halves[0]);
+    }
+    rb_set_run(&halves[1]);
+    if (spawned)
+    {
+        pthread_join(thread, NULL);
+    }
+    rb_discard_all(task, &halves[0]);
+    rb_discard_all(task, &halves[1]);
+
+    // The root of a stays, between the two results, when union always does
+    // and when intersection finds it in b or difference does not
+    RB_Node *l = halves[0].result;
+    RB_Node *r = halves[1].result;
+    hl = halves[0].height;
+    hr = halves[1].height;
+    rb_discard_node(task, match);
+    if (task->op == RB_UNION || (task->op == RB_INTERSECT) == (match != NULL))
+    {
+        task->result = rb_join_nodes(tree, l, hl, a, r, hr, &task->height);
+    }
+    else
+    {
+        rb_discard_node(task, a);
+        task->result = rb_concat_nodes(tree, l, hl, r, hr, &task->height);
+    }
+}
+
+/* Node of key in the subtree of root, or NULL */
+static RB_Node *rb_find_below(RB_Tree *tree, RB_Node *root, T key)
+{
+    while (root != &tree->nil)
+    {
+        int cmp = compCMP(key, root->data);
+        if (cmp == 0)
+        {
+            return root;
+        }
+        root = cmp < 0 ? root->left : root->right;
+    }
+    return NULL;
+}
+
+/* Link node into tree like rb_insert, unless its key is already there */
+static int rb_link(RB_Tree *tree, RB_Node *node)
+{
+    RB_Node *parent = NULL;
+    RB_Node *current = tree->root;
+    int cmp = 0;
+    while (current != &tree->nil)
+    {
+        cmp = compCMP(node->data, current->data);
+        if (cmp == 0)
+        {
+            return 0;
+        }
+        parent = current;
+        current = cmp < 0 ? current->left : current->right;
+    }
+
+    node->left = node->right = &tree->nil;
+    rb_set_parent_color(node, parent, RED);
+#ifdef RB_ORDER_STATISTICS
+    node->size = 1;
+    for (current = parent; current; current = rb_parent(current))
+    {
+        current->size++;
+    }
+#endif // RB_ORDER_STATISTICS
+    if (!parent)
+    {
+        tree->root = node;
+    }
+    else if (cmp < 0)
+    {
+        parent->left = node;
+    }
+    else
+    {
+        parent->right = node;
+    }
+    rb_insert_fixup(tree, node);
+    return 1;
+}
+
+/* Run the whole of task, whose a and b differ in size by RB_SET_SKEW or
+ * more, on this thread with a descent into the larger subtree for each node
+ * of the smaller one. The result is built in tree->root */
+static void rb_set_lopsided(RB_SetTask *task, int a_smaller)
+{
+    RB_Tree *tree = task->tree;
+    RB_SetOp op = task->op;
+    tree->root = a_smaller ? task->a : task->b;
+    RB_Node *node = rb_flatten(tree);
+    RB_Node *large = a_smaller ? task->b : task->a;
+
+    if (op == RB_UNION || (op == RB_DIFFERENCE && !a_smaller))
+    {
+        // The larger tree is the result, which the nodes of the smaller one
+        // join or leave one by one
+        tree->root = large;
+        while (node)
+        {
+            RB_Node *next = node->right;
+            if (op == RB_UNION && rb_link(tree, node))
+            {
+                node = next;
+                continue;
+            }
+            RB_Node *found = op == RB_DIFFERENCE
+                               ? rb_find_below(tree, tree->root, node->data)
+                               : NULL;
+            if (found)
+            {
+                rb_unlink(tree, found);
+                rb_discard_node(task, found);
+            }
+            rb_discard_node(task, node);
+            node = next;
+        }
+        return;
+    }
+
+    // The smaller tree is the result, rebuilt from the nodes it keeps
+    RB_Node head;
+    RB_Node *tail = &head;
+    size_t kept = 0;
+    while (node)
+    {
+        RB_Node *next = node->right;
+        int found = rb_find_below(tree, large, node->data) != NULL;
+        if (found == (op == RB_INTERSECT))
+        {
+            tail->right = node;
+            tail = node;
+            kept++;
+        }
+        else
+        {
+            rb_discard_node(task, node);
+        }
+        node = next;
+    }
+    tail->right = NULL;
+    rb_discard(task, large);
+    rb_build_from_chain(tree, head.right, kept);
+}
+
+/* Number of threads a set operation may use */
+static unsigned rb_set_threads(unsigned threads)
+{
+#ifdef RB_STATS
+    // The counters are not atomic
+    (void)threads;
+    return 1;
+#else
+    if (threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (unsigned)online : 1;
+    }
+    return threads;
+#endif // RB_STATS
+}
+
+/* Run op on a and b in the larger of the two trees, free the other one and
+ * return the survivor */
+static RB_Tree *rb_set_operation(RB_Tree *a, RB_Tree *b, RB_SetOp op,
+                                 unsigned threads)
+{
+    if (!a || !b || a == b || !rb_can_share_memory(a, b))
+    {
+        return NULL;
+    }
+    rb_share_memory(a, b);
+
+    RB_Tree *tree = a->size >= b->size ? a : b;
+    RB_Tree *other = tree == a ? b : a;
+    RB_SetTask task;
+    task.tree = tree;
+    task.op = op;
+    task.a = tree == a ? a->root : rb_adopt(tree, a);
+    task.ha = rb_black_height(tree, task.a);
+    task.b = tree == b ? b->root : rb_adopt(tree, b);
+    task.hb = rb_black_height(tree, task.b);
+    task.threads = rb_set_threads(threads);
+    task.discarded = task.last = NULL;
+
+    size_t total = a->size + b->size;
+    size_t smaller = a->size < b->size ? a->size : b->size;
+    if (smaller * RB_SET_SKEW <= total - smaller)
+    {
+        rb_set_lopsided(&task, a->size < b->size);
+    }
+    else
+    {
+        rb_set_run(&task);
+        tree->root = task.result;
+    }
+    tree->size = total - rb_free_discarded(tree, task.discarded);
+    tree->generation++;
+    rb_release(other);
+    return tree;
+}
+
+RB_Tree *rb_union(RB_Tree *a, RB_Tree *b, unsigned threads)
+{
+    return rb_set_operation(a, b, RB_UNION, threads);
+}
+
+RB_Tree *rb_intersect(RB_Tree *a, RB_Tree *b, unsigned threads)
+{
+    return rb_set_operation(a, b, RB_INTERSECT, threads);
+}
+
+RB_Tree *rb_difference(RB_Tree *a, RB_Tree *b, unsigned threads)
+{
+    return rb_set_operation(a, b, RB_DIFFERENCE, threads);
+}
@@ -0,0 +1,221 @@
+#include "rb_tree_internal.h"
+
+/* Index of the shard holding data: the number of bounds <= data */
+static size_t rb_shard_index(const RB_Sharded *tree, T data)
+{
+    size_t lo = 0;
+    size_t hi = tree->count - 1;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (compCMP(tree->bounds[mid], data) <= 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void rb_sharded_free(RB_Sharded *tree, size_t initialized)
+{
+    for (size_t i = 0; i < initialized; i++)
+    {
+        pthread_mutex_destroy(&tree->shards[i].lock);
+        rb_tree_destroy(tree->shards[i].tree);
+    }
+    if (tree->shards)
+    {
+        rb_free(&tree->allocator, tree->shards,
+                tree->count * sizeof(RB_Shard));
+    }
+    if (tree->bounds)
+    {
+        rb_free(&tree->allocator, tree->bounds,
+                (tree->count - 1) * sizeof(T));
+    }
+    rb_free(&tree->allocator, tree, sizeof(RB_Sharded));
+}
+
+RB_Sharded *rb_sharded_new(const T *bounds, size_t n)
+{
+    if (!bounds && n)
+    {
+        return NULL;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        if (compCMP(bounds[i - 1], bounds[i]) >= 0)
+        {
+            return NULL;
+        }
+    }
+
+    RB_Sharded *tree = rb_alloc(&rb_default_allocator, sizeof(RB_Sharded));
+    if (!tree)
+    {
+        fprintf(stderr, "insufficient memory (rb_sharded_new)\n");
+        return NULL;
+    }
+    tree->allocator = rb_default_allocator;
+    tree->count = n + 1;
+    tree->bounds = n ? rb_alloc(&tree->allocator, n * sizeof(T)) : NULL;
+    tree->shards = rb_alloc(&tree->allocator, tree->count * sizeof(RB_Shard));
+    if ((n && !tree->bounds) || !tree->shards)
+    {
+        fprintf(stderr, "insufficient memory (rb_sharded_new)\n");
+        rb_sharded_free(tree, 0);
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        tree->bounds[i] = bounds[i];
+    }
+
+    for (size_t i = 0; i < tree->count; i++)
+    {
+        RB_Shard *shard = &tree->shards[i];
+        shard->tree = rb_tree_new_with_pool(0);
+        if (!shard->tree)
+        {
+            rb_sharded_free(tree, i);
+            return NULL;
+        }
+        if (pthread_mutex_init(&shard->lock, NULL) != 0)
+        {
+            rb_tree_destroy(shard->tree);
+            rb_sharded_free(tree, i);
+            return NULL;
+        }
+    }
+    return tree;
+}
+
+void rb_sharded_destroy(RB_Sharded *tree)
+{
+    if (!tree)
+    {
+        return;
+    }
+    rb_sharded_free(tree, tree->count);
+}
+
+int rb_sharded_insert(RB_Sharded *tree, T data)
+{
+    if (!tree)
+    {
+        return -1;
+    }
+
+    RB_Shard *shard = &tree->shards[rb_shard_index(tree, data)];
+    int inserted;
+    pthread_mutex_lock(&shard->lock);
+    RB_Node *node =
+        rb_insert_from(shard->tree, shard->tree->root, data, &inserted);
+    pthread_mutex_unlock(&shard->lock);
+    return node ? inserted : -1;
+}
+
+int rb_sharded_find(RB_Sharded *tree, T data, T *out)
+{
+    if (!tree)
+    {
+        return 0;
+    }
+
+    RB_Shard *shard = &tree->shards[rb_shard_index(tree, data)];
+    pthread_mutex_lock(&shard->lock);
+    RB_Node *node = rb_find(shard->tree, data);
+    if (node && out)
+    {
+        *out = node->data;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return node != NULL;
+}
+
+int rb_sharded_delete(RB_Sharded *tree, T data)
+{
+    if (!tree)
+    {
+        return 0;
+    }
+
+    RB_Shard *shard = &tree->shards[rb_shard_index(tree, data)];
+    pthread_mutex_lock(&shard->lock);
+    RB_Node *node = rb_find(shard->tree, data);
+    rb_delete(shard->tree, node);
+    pthread_mutex_unlock(&shard->lock);
+    return node != NULL;
+}
+
+size_t rb_sharded_size(RB_Sharded *tree)
+{
+    size_t size = 0;
+
+    if (!tree)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < tree->count; i++)
+    {
+        pthread_mutex_lock(&tree->shards[i].lock);
+        size += tree->shards[i].tree->size;
+        pthread_mutex_unlock(&tree->shards[i].lock);
+    }
+    return size;
+}
+
+/* Visit in order the nodes of shards first..last from lo to hi excluded, a
+ * NULL bound leaving that side open, until visit asks to stop */
+static size_t rb_sharded_walk(RB_Sharded *tree, size_t first, size_t last,
+                              const T *lo, const T *hi, RB_Visit visit,
+                              void *ctx)
+{
+    size_t count = 0;
+    int stop = 0;
+
+    for (size_t i = first; i <= last && !stop; i++)
+    {
+        RB_Shard *shard = &tree->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        RB_Node *node =
+            lo ? rb_lower_bound(shard->tree, *lo) : rb_first(shard->tree);
+        for (; node && (!hi || compCMP(node->data, *hi) < 0);
+             node = rb_next(shard->tree, node))
+        {
+            count++;
+            if (visit(node, ctx))
+            {
+                stop = 1;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return count;
+}
+
+size_t rb_sharded_range(RB_Sharded *tree, T lo, T hi, RB_Visit visit,
+                        void *ctx)
+{
+    if (!tree || !visit || compCMP(lo, hi) >= 0)
+    {
+        return 0;
+    }
+    return rb_sharded_walk(tree, rb_shard_index(tree, lo),
+                           rb_shard_index(tree, hi), &lo, &hi, visit, ctx);
+}
+
+size_t rb_sharded_visit(RB_Sharded *tree, RB_Visit visit, void *ctx)
+{
+    if (!tree || !visit)
+    {
+        return 0;
+    }
+    return rb_sharded_walk(tree, 0, tree->count - 1, NULL, NULL, visit, ctx);
+}
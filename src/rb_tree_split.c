@@ -0,0 +1,416 @@
+#include "rb_tree_internal.h"
+
+// Subtrees
+
+size_t rb_black_height(RB_Tree *tree, RB_Node *node)
+{
+    size_t height = 0;
+    for (; node != &tree->nil; node = node->left)
+    {
+        height += rb_color(node) == BLACK;
+    }
+    return height;
+}
+
+RB_Node *rb_detach(RB_Tree *tree, RB_Node *node, size_t *height)
+{
+    if (node != &tree->nil)
+    {
+        rb_set_parent(node, NULL);
+        if (rb_color(node) == RED)
+        {
+            rb_set_color(node, BLACK);
+            (*height)++;
+        }
+    }
+    return node;
+}
+
+RB_Node *rb_join_nodes(RB_Tree *tree, RB_Node *l, size_t hl, RB_Node *x,
+                       RB_Node *r, size_t hr, size_t *height)
+{
+    RB_Node *nil = &tree->nil;
+
+    if (hl == hr)
+    {
+        x->left = l;
+        x->right = r;
+        rb_set_parent_color(x, NULL, BLACK);
+        if (l != nil)
+        {
+            rb_set_parent(l, x);
+        }
+        if (r != nil)
+        {
+            rb_set_parent(r, x);
+        }
+#ifdef RB_ORDER_STATISTICS
+        x->size = l->size + r->size + 1;
+#endif // RB_ORDER_STATISTICS
+        *height = hl + 1;
+        return x;
+    }
+
+    // The taller subtree hangs from a black node of the stack while it is
+    // fixed, so that no rotation reaches tree->root and subtrees of one tree
+    // can be joined on several threads
+    int taller_left = hl > hr;
+    RB_Node *taller = taller_left ? l : r;
+    RB_Node top;
+    top.left = taller;
+    top.right = nil;
+    rb_set_parent_color(&top, NULL, BLACK);
+    rb_set_parent(taller, &top);
+
+    // Find the first black node of the right spine of l, or of the left
+    // spine of r, whose black height is the one of the shorter side
+    RB_Node *parent = &top;
+    RB_Node *node = taller;
+    size_t h = taller_left ? hl : hr;
+    size_t shorter = taller_left ? hr : hl;
+    while (h > shorter || rb_color(node) == RED)
+    {
+        h -= rb_color(node) == BLACK;
+        parent = node;
+        node = taller_left ? node->right : node->left;
+    }
+
+    RB_Node *other = taller_left ? r : l;
+    x->left = taller_left ? node : other;
+    x->right = taller_left ? other : node;
+    rb_set_parent_color(x, parent, RED);
+    if (taller_left)
+    {
+        parent->right = x;
+    }
+    else
+    {
+        parent->left = x;
+    }
+    if (node != nil)
+    {
+        rb_set_parent(node, x);
+    }
+    if (other != nil)
+    {
+        rb_set_parent(other, x);
+    }
+#ifdef RB_ORDER_STATISTICS
+    x->size = node->size + other->size + 1;
+    for (RB_Node *p = parent; p != &top; p = rb_parent(p))
+    {
+        p->size += other->size + 1;
+    }
+#endif // RB_ORDER_STATISTICS
+
+    // The fixup stops below top, leaving a root that may have turned red
+    rb_insert_fixup(tree, x);
+    RB_Node *root = top.left;
+    rb_set_parent(root, NULL);
+    *height = taller_left ? hl : hr;
+    if (rb_color(root) == RED)
+    {
+        rb_set_color(root, BLACK);
+        (*height)++;
+    }
+    return root;
+}
+
+/* Point the nil children of the subtree of node at another nil node */
+static void rb_renil(RB_Node *node, RB_Node *old, RB_Node *nil)
+{
+    while (node != old)
+    {
+        if (node->left == old)
+        {
+            node->left = nil;
+        }
+        else
+        {
+            rb_renil(node->left, old, nil);
+        }
+        if (node->right == old)
+        {
+            node->right = nil;
+            return;
+        }
+        node = node->right;
+    }
+}
+
+RB_Node *rb_adopt(RB_Tree *tree, RB_Tree *other)
+{
+    if (other->root == &other->nil)
+    {
+        return &tree->nil;
+    }
+    rb_renil(other->root, &other->nil, &tree->nil);
+    return other->root;
+}
+
+#ifndef RB_ORDER_STATISTICS
+static RB_Node *rb_subtree_first(RB_Tree *tree, RB_Node *node)
+{
+    if (node == &tree->nil)
+    {
+        return NULL;
+    }
+    while (node->left != &tree->nil)
+    {
+        node = node->left;
+    }
+    return node;
+}
+
+/* Successor of node within its detached subtree */
+static RB_Node *rb_subtree_next(RB_Tree *tree, RB_Node *node)
+{
+    if (node->right != &tree->nil)
+    {
+        return rb_subtree_first(tree, node->right);
+    }
+    RB_Node *parent = rb_parent(node);
+    while (parent && node == parent->right)
+    {
+        node = parent;
+        parent = rb_parent(parent);
+    }
+    return parent;
+}
+#endif // RB_ORDER_STATISTICS
+
+/* Number of nodes of the detached subtree a, given that a and b hold total
+ * nodes. Without subtree sizes both are walked in step until one ends, which
+ * costs O(min(|a|, |b|)) */
+static size_t rb_count(RB_Tree *tree, RB_Node *a, RB_Node *b, size_t total)
+{
+#ifdef RB_ORDER_STATISTICS
+    (void)tree;
+    (void)b;
+    (void)total;
+    return a->size;
+#else
+    RB_Node *x = rb_subtree_first(tree, a);
+    RB_Node *y = rb_subtree_first(tree, b);
+    size_t count = 0;
+    while (x && y)
+    {
+        count++;
+        x = rb_subtree_next(tree, x);
+        y = rb_subtree_next(tree, y);
+    }
+    return x ? total - count : count;
+#endif // RB_ORDER_STATISTICS
+}
+
+// Split
+
+RB_Node *rb_split_nodes(RB_Tree *tree, RB_Node *root, size_t height, T key,
+                        RB_Node **l, size_t *hl, RB_Node **r, size_t *hr)
+{
+    // Walk down to key, keeping the black height below each node
+    RB_Node *nil = &tree->nil;
+    RB_Node *path[RB_MAX_DEPTH];
+    size_t heights[RB_MAX_DEPTH];
+    unsigned char went_left[RB_MAX_DEPTH];
+    size_t depth = 0;
+    RB_Node *node = root;
+    RB_Node *found = NULL;
+    *l = *r = nil;
+    *hl = *hr = 0;
+    while (node != nil)
+    {
+        height -= rb_color(node) == BLACK;
+        int cmp = compCMP(key, node->data);
+        if (cmp == 0)
+        {
+            *hl = *hr = height;
+            *l = rb_detach(tree, node->left, hl);
+            *r = rb_detach(tree, node->right, hr);
+            found = node;
+            break;
+        }
+        path[depth] = node;
+        heights[depth] = height;
+        went_left[depth] = cmp < 0;
+        depth++;
+        node = cmp < 0 ? node->left : node->right;
+    }
+
+    // Back up the path, each node joining the part on its side with its
+    // subtree on that side. The black heights telescope, so that all the
+    // joins together cost O(log n)
+    while (depth-- > 0)
+    {
+        RB_Node *parent = path[depth];
+        size_t h = heights[depth];
+        if (went_left[depth])
+        {
+            RB_Node *sibling = rb_detach(tree, parent->right, &h);
+            *r = rb_join_nodes(tree, *r, *hr, parent, sibling, h, hr);
+        }
+        else
+        {
+            RB_Node *sibling = rb_detach(tree, parent->left, &h);
+            *l = rb_join_nodes(tree, sibling, h, parent, *l, *hl, hl);
+        }
+    }
+    return found;
+}
+
+int rb_split(RB_Tree *tree, T key, RB_Tree **left, RB_Tree **right)
+{
+    if (!tree || !left || !right)
+    {
+        return -1;
+    }
+
+    // The part that does not stay in tree gets a tree sharing its memory
+    RB_Tree *other = rb_tree_new_with_allocator(&tree->allocator);
+    if (!other)
+    {
+        fprintf(stderr, "insufficient memory (rb_split)\n");
+        return -1;
+    }
+    if (tree->pool)
+    {
+        other->pool = tree->pool;
+        tree->pool->refs++;
+    }
+
+    // The node of key, if any, starts the right part
+    RB_Node *nil = &tree->nil;
+    RB_Node *l, *r;
+    size_t hl, hr;
+    RB_Node *node =
+        rb_split_nodes(tree, tree->root, rb_black_height(tree, tree->root),
+                       key, &l, &hl, &r, &hr);
+    if (node)
+    {
+        r = rb_join_nodes(tree, nil, 0, node, r, hr, &hr);
+    }
+
+    // The smaller part moves to the new tree
+    size_t total = tree->size;
+    size_t left_size = rb_count(tree, l, r, total);
+    int left_moves = left_size < total - left_size;
+    RB_Node *moved = left_moves ? l : r;
+    if (moved != nil)
+    {
+        rb_renil(moved, nil, &other->nil);
+        other->root = moved;
+    }
+    tree->root = left_moves ? r : l;
+    other->size = left_moves ? left_size : total - left_size;
+    tree->size = total - other->size;
+    tree->generation++;
+    other->generation++;
+
+    *left = left_moves ? other : tree;
+    *right = left_moves ? tree : other;
+    return 0;
+}
+
+// Join
+
+int rb_can_share_memory(const RB_Tree *a, const RB_Tree *b)
+{
+    if (a->allocator.alloc != b->allocator.alloc
+        || a->allocator.free != b->allocator.free
+        || a->allocator.ctx != b->allocator.ctx)
+    {
+        return 0;
+    }
+    if (a->pool == b->pool)
+    {
+        return 1;
+    }
+    // A pool shared with another tree cannot be merged away
+    return a->pool && b->pool && (a->pool->refs == 1 || b->pool->refs == 1);
+}
+
+void rb_share_memory(RB_Tree *a, RB_Tree *b)
+{
+    if (a->pool != b->pool)
+    {
+        a->pool = b->pool = rb_pool_merge(a->pool, b->pool);
+    }
+}
+
+void rb_release(RB_Tree *tree)
+{
+    if (tree->pool)
+    {
+        rb_pool_destroy(tree->pool);
+    }
+    rb_free(&tree->allocator, tree, sizeof(RB_Tree));
+}
+
+/* Join left, x and right in the larger of the two trees, free the other one
+ * and return the survivor */
+static RB_Tree *rb_join_trees(RB_Tree *left, RB_Node *x, RB_Tree *right)
+{
+    rb_share_memory(left, right);
+    RB_Tree *tree = left->size >= right->size ? left : right;
+    RB_Tree *other = tree == left ? right : left;
+
+    RB_Node *l = tree == left ? left->root : rb_adopt(tree, left);
+    RB_Node *r = tree == right ? right->root : rb_adopt(tree, right);
+    size_t height;
+    tree->root = rb_join_nodes(tree, l, rb_black_height(tree, l), x, r,
+                               rb_black_height(tree, r), &height);
+    tree->size = left->size + right->size + 1;
+    tree->generation++;
+    rb_release(other);
+    return tree;
+}
+
+RB_Tree *rb_join(RB_Tree *left, T pivot, RB_Tree *right)
+{
+    if (!left || !right || left == right || !rb_can_share_memory(left, right))
+    {
+        return NULL;
+    }
+
+    RB_Node *last = rb_last(left);
+    RB_Node *first = rb_first(right);
+    if ((last && compCMP(last->data, pivot) >= 0)
+        || (first && compCMP(pivot, first->data) >= 0))
+    {
+        return NULL;
+    }
+
+    RB_Node *x = rb_node_alloc(left);
+    if (!x)
+    {
+        fprintf(stderr, "insufficient memory (rb_join)\n");
+        return NULL;
+    }
+    x->data = pivot;
+    return rb_join_trees(left, x, right);
+}
+
+RB_Tree *rb_concat(RB_Tree *left, RB_Tree *right)
+{
+    if (!left || !right || left == right || !rb_can_share_memory(left, right))
+    {
+        return NULL;
+    }
+
+    RB_Node *last = rb_last(left);
+    RB_Node *first = rb_first(right);
+    if (last && first && compCMP(last->data, first->data) >= 0)
+    {
+        return NULL;
+    }
+    if (!first)
+    {
+        left->generation++;
+        rb_tree_destroy(right);
+        return left;
+    }
+
+    // The smallest node of right becomes the pivot
+    rb_unlink(right, first);
+    return rb_join_trees(left, first, right);
+}
@@ -7,26 +7,27 @@ void rb_rotate_left(RB_Tree *tree, RB_Node *x)
         return;
     }
 
+    RB_STAT(tree, rotations_left);
     RB_Node *y = x->right;
 
     x->right = y->left;
     if (y->left != &tree->nil)
     {
-        y->left->parent = x;
+        rb_set_parent(y->left, x);
     }
     if (y != &tree->nil)
     {
-        y->parent = x->parent;
+        rb_set_parent(y, rb_parent(x));
     }
-    if (x->parent)
+    if (rb_parent(x))
     {
-        if (x == x->parent->left)
+        if (x == rb_parent(x)->left)
         {
-            x->parent->left = y;
+            rb_parent(x)->left = y;
         }
         else
         {
-            x->parent->right = y;
+            rb_parent(x)->right = y;
         }
     }
     else
@@ -37,8 +38,13 @@ void rb_rotate_left(RB_Tree *tree, RB_Node *x)
     y->left = x;
     if (x != &tree->nil)
     {
-        x->parent = y;
+        rb_set_parent(x, y);
     }
+
+#ifdef RB_ORDER_STATISTICS
+    y->size = x->size;
+    x->size = x->left->size + x->right->size + 1;
+#endif // RB_ORDER_STATISTICS
 }
 
 void rb_rotate_right(RB_Tree *tree, RB_Node *x)
@@ -48,27 +54,28 @@ void rb_rotate_right(RB_Tree *tree, RB_Node *x)
         return;
     }
 
+    RB_STAT(tree, rotations_right);
     RB_Node *y = x->left;
 
     x->left = y->right;
     if (y->right != &tree->nil)
     {
-        y->right->parent = x;
+        rb_set_parent(y->right, x);
     }
 
     if (y != &tree->nil)
     {
-        y->parent = x->parent;
+        rb_set_parent(y, rb_parent(x));
     }
-    if (x->parent)
+    if (rb_parent(x))
     {
-        if (x == x->parent->right)
+        if (x == rb_parent(x)->right)
         {
-            x->parent->right = y;
+            rb_parent(x)->right = y;
         }
         else
         {
-            x->parent->left = y;
+            rb_parent(x)->left = y;
         }
     }
     else
@@ -79,6 +86,11 @@ void rb_rotate_right(RB_Tree *tree, RB_Node *x)
     y->right = x;
     if (x != &tree->nil)
     {
-        x->parent = y;
+        rb_set_parent(x, y);
     }
+
+#ifdef RB_ORDER_STATISTICS
+    y->size = x->size;
+    x->size = x->left->size + x->right->size + 1;
+#endif // RB_ORDER_STATISTICS
 }
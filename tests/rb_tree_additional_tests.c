@@ -36,14 +36,14 @@ static ValidationResult validate_node(RB_Tree *tree, RB_Node *node, int has_min,
         return result;
     }
 
-    if ((node->left != &tree->nil && node->left->parent != node)
-        || (node->right != &tree->nil && node->right->parent != node))
+    if ((node->left != &tree->nil && rb_parent(node->left) != node)
+        || (node->right != &tree->nil && rb_parent(node->right) != node))
     {
         return result;
     }
 
-    if (node->color == RED
-        && (node->left->color == RED || node->right->color == RED))
+    if (rb_color(node) == RED
+        && (rb_color(node->left) == RED || rb_color(node->right) == RED))
     {
         return result;
     }
@@ -59,7 +59,8 @@ static ValidationResult validate_node(RB_Tree *tree, RB_Node *node, int has_min,
     }
 
     result.ok = 1;
-    result.black_height = left.black_height + (node->color == BLACK ? 1 : 0);
+    result.black_height =
+        left.black_height + (rb_color(node) == BLACK ? 1 : 0);
     return result;
 }
 
@@ -71,7 +72,7 @@ static int validate_tree_strict(RB_Tree *tree)
     }
 
     if (tree->nil.left != &tree->nil || tree->nil.right != &tree->nil
-        || tree->nil.color != BLACK)
+        || rb_color(&tree->nil) != BLACK)
     {
         return 0;
     }
@@ -81,7 +82,8 @@ static int validate_tree_strict(RB_Tree *tree)
         return 1;
     }
 
-    if (!tree->root || tree->root->parent != NULL || tree->root->color != BLACK)
+    if (!tree->root || rb_parent(tree->root) != NULL
+        || rb_color(tree->root) != BLACK)
     {
         return 0;
     }
@@ -341,7 +343,7 @@ Test(rb_tree_additional_delete, deletes_root_with_only_left_child)
     cr_assert_not_null(rb_find(tree, 10));
     cr_assert_null(rb_find(tree, 20));
     cr_assert_eq(validate_tree_strict(tree), 1);
-    cr_assert_eq(tree->root->parent, NULL);
+    cr_assert_eq(rb_parent(tree->root), NULL);
 
     rb_tree_destroy(tree);
 }
@@ -360,7 +362,7 @@ Test(rb_tree_additional_delete, deletes_root_with_only_right_child)
     cr_assert_not_null(rb_find(tree, 20));
     cr_assert_null(rb_find(tree, 10));
     cr_assert_eq(validate_tree_strict(tree), 1);
-    cr_assert_eq(tree->root->parent, NULL);
+    cr_assert_eq(rb_parent(tree->root), NULL);
 
     rb_tree_destroy(tree);
 }
@@ -388,7 +390,43 @@ Test(rb_tree_additional_delete, deletes_root_with_two_children_and_deep_successo
     cr_assert_not_null(rb_find(tree, 30));
     cr_assert_not_null(rb_find(tree, 40));
     cr_assert_eq(validate_tree_strict(tree), 1);
-    cr_assert_eq(tree->root->parent, NULL);
+    cr_assert_eq(rb_parent(tree->root), NULL);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_additional_delete, keeps_handles_to_other_nodes_valid)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    const int count = 128;
+    RB_Node *handles[count];
+    for (int i = 0; i < count; i++)
+    {
+        handles[i] = rb_insert(tree, i);
+    }
+
+    // Deleting inner nodes relinks their successors instead of moving data
+    for (int i = 0; i < count; i += 3)
+    {
+        rb_delete(tree, handles[i]);
+        handles[i] = NULL;
+        cr_assert_eq(validate_tree_strict(tree), 1);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (handles[i])
+        {
+            cr_assert_eq(handles[i]->data, i);
+            cr_assert_eq(rb_find(tree, i), handles[i]);
+        }
+        else
+        {
+            cr_assert_null(rb_find(tree, i));
+        }
+    }
 
     rb_tree_destroy(tree);
 }
@@ -535,3 +573,109 @@ Test(rb_tree_additional_exhaustive,
                  failed_delete_step);
     cr_assert_eq(scenario_count, 120 * 120);
 }
+
+TestSuite(rb_tree_additional_size, .timeout = 3);
+
+Test(rb_tree_additional_size, counts_only_real_insertions_and_deletions)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    cr_assert_eq(rb_tree_size(tree), 0);
+    cr_assert_eq(rb_tree_size(NULL), 0);
+
+    for (int i = 0; i < 50; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(rb_tree_size(tree), 50);
+
+    for (int i = 0; i < 50; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(rb_tree_size(tree), 50);
+
+    for (int i = 0; i < 50; i += 5)
+    {
+        rb_delete(tree, rb_find(tree, i));
+    }
+    cr_assert_eq(rb_tree_size(tree), 40);
+
+    rb_delete(tree, rb_find(tree, 0));
+    rb_delete(tree, NULL);
+    cr_assert_eq(rb_tree_size(tree), 40);
+
+    for (int i = 0; i < 50; i++)
+    {
+        rb_delete(tree, rb_find(tree, i));
+    }
+    cr_assert_eq(rb_tree_size(tree), 0);
+    cr_assert_eq(tree->root, &tree->nil);
+
+    rb_tree_destroy(tree);
+}
+
+TestSuite(rb_tree_additional_destroy, .timeout = 8);
+
+static void record_data(T data, void *ctx)
+{
+    int *seen = ctx;
+    seen[data]++;
+}
+
+Test(rb_tree_additional_destroy, destructor_sees_every_node_once)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int seen[512] = { 0 };
+    for (int i = 0; i < 512; i++)
+    {
+        rb_insert(tree, (i * 37) % 512);
+    }
+
+    rb_tree_destroy_with(tree, record_data, seen);
+    for (int i = 0; i < 512; i++)
+    {
+        cr_assert_eq(seen[i], 1, "value %d seen %d times", i, seen[i]);
+    }
+
+    rb_tree_destroy_with(NULL, record_data, seen);
+}
+
+Test(rb_tree_additional_destroy, destroys_a_large_tree_iteratively)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    for (int i = 0; i < 200000; i++)
+    {
+        rb_insert(tree, i);
+    }
+    rb_tree_destroy_with(tree, NULL, NULL);
+}
+
+TestSuite(rb_tree_additional_layout, .timeout = 3);
+
+Test(rb_tree_additional_layout, parent_and_color_are_set_independently)
+{
+    RB_Node parent;
+    RB_Node node;
+
+    rb_set_parent_color(&node, &parent, RED);
+    cr_assert_eq(rb_parent(&node), &parent);
+    cr_assert_eq(rb_color(&node), RED);
+
+    rb_set_color(&node, BLACK);
+    cr_assert_eq(rb_parent(&node), &parent);
+    cr_assert_eq(rb_color(&node), BLACK);
+
+    rb_set_parent(&node, NULL);
+    cr_assert_null(rb_parent(&node));
+    cr_assert_eq(rb_color(&node), BLACK);
+
+    rb_set_color(&node, RED);
+    rb_set_parent(&node, &parent);
+    cr_assert_eq(rb_parent(&node), &parent);
+    cr_assert_eq(rb_color(&node), RED);
+}
@@ -0,0 +1,168 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+typedef struct
+{
+    size_t allocs;
+    size_t frees;
+    size_t live_bytes;
+} CountingContext;
+
+static void *counting_alloc(void *ctx, size_t size)
+{
+    CountingContext *counts = ctx;
+    counts->allocs++;
+    counts->live_bytes += size;
+    return malloc(size);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t size)
+{
+    CountingContext *counts = ctx;
+    counts->frees++;
+    counts->live_bytes -= size;
+    free(ptr);
+}
+
+typedef struct
+{
+    char *buffer;
+    size_t capacity;
+    size_t offset;
+} Arena;
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+    Arena *arena = ctx;
+    size_t aligned = (size + 15) & ~(size_t)15;
+    if (arena->offset + aligned > arena->capacity)
+    {
+        return NULL;
+    }
+
+    void *ptr = arena->buffer + arena->offset;
+    arena->offset += aligned;
+    return ptr;
+}
+
+TestSuite(rb_tree_allocator, .timeout = 5);
+
+Test(rb_tree_allocator, null_allocator_uses_the_default)
+{
+    RB_Tree *tree = rb_tree_new_with_allocator(NULL);
+
+    cr_assert_not_null(tree);
+    cr_assert_not_null(tree->allocator.alloc);
+    cr_assert_not_null(tree->allocator.free);
+    cr_assert_eq(tree->root, &tree->nil);
+    cr_assert_not_null(rb_insert(tree, 1));
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_allocator, every_allocation_goes_through_the_allocator)
+{
+    CountingContext counts = { 0, 0, 0 };
+    RB_Allocator allocator = { counting_alloc, counting_free, &counts };
+
+    RB_Tree *tree = rb_tree_new_with_allocator(&allocator);
+    cr_assert_not_null(tree);
+    cr_assert_eq(counts.allocs, 1);
+
+    for (int i = 0; i < 100; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(counts.allocs, 101);
+
+    for (int i = 0; i < 100; i += 2)
+    {
+        rb_delete(tree, rb_find(tree, i));
+    }
+    cr_assert_eq(counts.frees, 50);
+
+    rb_tree_destroy(tree);
+    cr_assert_eq(counts.allocs, counts.frees);
+    cr_assert_eq(counts.live_bytes, 0);
+}
+
+Test(rb_tree_allocator, works_with_an_arena_without_free)
+{
+    size_t size = 1 << 16;
+    char *buffer = malloc(size);
+    cr_assert_not_null(buffer);
+    Arena arena = { buffer, size, 0 };
+    RB_Allocator allocator = { arena_alloc, NULL, &arena };
+
+    RB_Tree *tree = rb_tree_new_with_allocator(&allocator);
+    cr_assert_not_null(tree);
+    cr_assert((char *)tree >= buffer && (char *)tree < buffer + size);
+
+    for (int i = 0; i < 200; i++)
+    {
+        RB_Node *node = rb_insert(tree, i);
+        cr_assert_not_null(node);
+        cr_assert((char *)node >= buffer
+                  && (char *)node < buffer + size);
+    }
+    rb_delete(tree, rb_find(tree, 100));
+    cr_assert_null(rb_find(tree, 100));
+    cr_assert_not_null(rb_find(tree, 101));
+
+    rb_tree_destroy(tree);
+    free(buffer);
+}
+
+Test(rb_tree_allocator, reports_allocation_failures)
+{
+    char *buffer = malloc(sizeof(RB_Tree) + 64);
+    cr_assert_not_null(buffer);
+    Arena arena = { buffer, sizeof(RB_Tree) + 64, 0 };
+    RB_Allocator allocator = { arena_alloc, NULL, &arena };
+
+    RB_Tree *tree = rb_tree_new_with_allocator(&allocator);
+    cr_assert_not_null(tree);
+
+    RB_Node *node = NULL;
+    for (int i = 0; i < 10; i++)
+    {
+        node = rb_insert(tree, i);
+        if (!node)
+        {
+            break;
+        }
+    }
+    cr_assert_null(node);
+
+    rb_tree_destroy(tree);
+    free(buffer);
+}
+
+Test(rb_tree_allocator, pooled_tree_takes_its_slabs_from_the_allocator)
+{
+    CountingContext counts = { 0, 0, 0 };
+    RB_Allocator allocator = { counting_alloc, counting_free, &counts };
+
+    // The tree, its pool and the first slab
+    RB_Tree *tree = rb_tree_new_with_pool_allocator(&allocator, 16);
+    cr_assert_not_null(tree);
+    cr_assert_not_null(tree->pool);
+    cr_assert_eq(counts.allocs, 3);
+
+    for (int i = 0; i < 16; i++)
+    {
+        cr_assert_not_null(rb_insert(tree, i));
+    }
+    cr_assert_eq(counts.allocs, 3);
+
+    // Growing past the reserve adds a slab
+    cr_assert_not_null(rb_insert(tree, 16));
+    cr_assert_eq(counts.allocs, 4);
+
+    rb_tree_destroy(tree);
+    cr_assert_eq(counts.frees, counts.allocs);
+    cr_assert_eq(counts.live_bytes, 0);
+}
@@ -0,0 +1,165 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+TestSuite(rb_tree_batch, .timeout = 10);
+
+Test(rb_tree_batch, inserts_a_sorted_batch)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int keys[500];
+    RB_Node *nodes[500];
+    for (int i = 0; i < 500; i++)
+    {
+        keys[i] = i * 3;
+    }
+
+    cr_assert_eq(rb_insert_batch(tree, keys, 500, nodes), 500);
+    cr_assert_eq(rb_tree_size(tree), 500);
+    cr_assert_eq(rb_test_validate(tree), 1);
+    for (int i = 0; i < 500; i++)
+    {
+        cr_assert_eq(rb_find(tree, keys[i]), nodes[i]);
+    }
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_batch, reports_nodes_in_the_order_of_the_keys)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    RB_Node *existing = rb_insert(tree, 50);
+    int keys[] = { 90, 10, 50, 70, 10, 30 };
+    RB_Node *nodes[6];
+
+    cr_assert_eq(rb_insert_batch(tree, keys, 6, nodes), 4);
+    cr_assert_eq(rb_tree_size(tree), 5);
+    cr_assert_eq(rb_test_validate(tree), 1);
+    for (int i = 0; i < 6; i++)
+    {
+        cr_assert_not_null(nodes[i]);
+        cr_assert_eq(nodes[i]->data, keys[i]);
+    }
+    cr_assert_eq(nodes[2], existing);
+    cr_assert_eq(nodes[1], nodes[4]);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_batch, interleaves_batches_with_an_existing_tree)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(0);
+    cr_assert_not_null(tree);
+
+    srand(99);
+    for (int i = 0; i < 2000; i++)
+    {
+        rb_insert(tree, rand() % 100000);
+    }
+
+    int keys[1024];
+    for (int round = 0; round < 20; round++)
+    {
+        // Nearly sorted batch: a sorted run with a few displaced keys
+        int base = rand() % 90000;
+        for (int i = 0; i < 1024; i++)
+        {
+            keys[i] = base + i * 7;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            keys[rand() % 1024] = rand() % 100000;
+        }
+
+        rb_insert_batch(tree, keys, 1024, NULL);
+        cr_assert_eq(rb_test_validate(tree), 1);
+        for (int i = 0; i < 1024; i++)
+        {
+            cr_assert_not_null(rb_find(tree, keys[i]));
+        }
+    }
+
+    size_t count = 0;
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        count++;
+    }
+    cr_assert_eq(count, rb_tree_size(tree));
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_batch, handles_empty_and_null_batches)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int key = 1;
+    cr_assert_eq(rb_insert_batch(tree, &key, 0, NULL), 0);
+    cr_assert_eq(rb_insert_batch(tree, NULL, 3, NULL), 0);
+    cr_assert_eq(rb_insert_batch(NULL, &key, 1, NULL), 0);
+    cr_assert_eq(rb_tree_size(tree), 0);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_batch, finds_a_batch_of_present_and_missing_keys)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        rb_insert(tree, i);
+    }
+
+    // More keys than interleaved descents, half of them missing
+    int keys[300];
+    RB_Node *out[300];
+    for (int i = 0; i < 300; i++)
+    {
+        keys[i] = (i * 7) % 1000;
+    }
+
+    size_t expected = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        expected += keys[i] % 2 == 0;
+    }
+    cr_assert_eq(rb_find_batch(tree, keys, 300, out), expected);
+    for (int i = 0; i < 300; i++)
+    {
+        cr_assert_eq(out[i], rb_find(tree, keys[i]));
+    }
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_batch, finds_in_empty_trees_and_small_batches)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int keys[] = { 4, 2 };
+    RB_Node *out[2] = { (RB_Node *)1, (RB_Node *)1 };
+    cr_assert_eq(rb_find_batch(tree, keys, 2, out), 0);
+    cr_assert_null(out[0]);
+    cr_assert_null(out[1]);
+
+    rb_insert(tree, 2);
+    cr_assert_eq(rb_find_batch(tree, keys, 2, out), 1);
+    cr_assert_null(out[0]);
+    cr_assert_eq(out[1]->data, 2);
+
+    cr_assert_eq(rb_find_batch(tree, keys, 0, out), 0);
+    cr_assert_eq(rb_find_batch(NULL, keys, 2, out), 0);
+
+    rb_tree_destroy(tree);
+}
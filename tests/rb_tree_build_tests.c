@@ -0,0 +1,133 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+static int contains_exactly(RB_Tree *tree, const int *values, size_t n)
+{
+    RB_Node *node = rb_first(tree);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!node || node->data != values[i])
+        {
+            return 0;
+        }
+        node = rb_next(tree, node);
+    }
+    return node == NULL && rb_tree_size(tree) == n;
+}
+
+TestSuite(rb_tree_build, .timeout = 10);
+
+Test(rb_tree_build, builds_valid_trees_of_every_small_size)
+{
+    int keys[300];
+    for (int i = 0; i < 300; i++)
+    {
+        keys[i] = i * 2;
+    }
+
+    for (size_t n = 0; n <= 300; n++)
+    {
+        RB_Tree *tree = rb_tree_build_sorted(keys, n);
+        cr_assert_not_null(tree);
+        cr_assert_eq(rb_test_validate(tree), 1, "invalid tree of size %zu", n);
+        cr_assert_eq(contains_exactly(tree, keys, n), 1);
+        rb_tree_destroy(tree);
+    }
+}
+
+Test(rb_tree_build, lays_nodes_out_contiguously_in_key_order)
+{
+    int keys[1000];
+    for (int i = 0; i < 1000; i++)
+    {
+        keys[i] = i;
+    }
+
+    RB_Tree *tree = rb_tree_build_sorted(keys, 1000);
+    cr_assert_not_null(tree);
+
+    RB_Node *first = rb_first(tree);
+    for (int i = 0; i < 1000; i++)
+    {
+        cr_assert_eq(rb_find(tree, i), first + i);
+    }
+
+    // The built tree keeps working as a regular tree
+    rb_delete(tree, rb_find(tree, 500));
+    cr_assert_not_null(rb_insert(tree, 5000));
+    cr_assert_eq(rb_test_validate(tree), 1);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_build, skips_duplicates_and_rejects_unsorted_input)
+{
+    int with_duplicates[] = { 1, 1, 2, 3, 3, 3, 7 };
+    int unique[] = { 1, 2, 3, 7 };
+    int unsorted[] = { 1, 3, 2 };
+
+    RB_Tree *tree = rb_tree_build_sorted(with_duplicates, 7);
+    cr_assert_not_null(tree);
+    cr_assert_eq(contains_exactly(tree, unique, 4), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
+    rb_tree_destroy(tree);
+
+    cr_assert_null(rb_tree_build_sorted(unsorted, 3));
+    cr_assert_null(rb_tree_build_sorted(NULL, 3));
+}
+
+Test(rb_tree_build, merge_keeps_existing_nodes_and_skips_duplicates)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    RB_Node *handles[50];
+    for (int i = 0; i < 50; i++)
+    {
+        handles[i] = rb_insert(tree, i * 4);
+    }
+
+    int batch[100];
+    for (int i = 0; i < 100; i++)
+    {
+        batch[i] = i * 2;
+    }
+    cr_assert_eq(rb_tree_merge_sorted(tree, batch, 100), 0);
+
+    cr_assert_eq(rb_test_validate(tree), 1);
+    cr_assert_eq(contains_exactly(tree, batch, 100), 1);
+    for (int i = 0; i < 50; i++)
+    {
+        cr_assert_eq(rb_find(tree, i * 4), handles[i]);
+    }
+
+    int unsorted[] = { 1000, 999 };
+    cr_assert_eq(rb_tree_merge_sorted(tree, unsorted, 2), -1);
+    cr_assert_eq(contains_exactly(tree, batch, 100), 1);
+
+    cr_assert_eq(rb_tree_merge_sorted(tree, NULL, 0), 0);
+    cr_assert_eq(rb_tree_size(tree), 100);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_build, merge_into_empty_and_pooled_trees)
+{
+    int batch[] = { -5, 0, 0, 4, 9 };
+    int unique[] = { -5, 0, 4, 9 };
+
+    RB_Tree *tree = rb_tree_new_with_pool(2);
+    cr_assert_not_null(tree);
+    cr_assert_eq(rb_tree_merge_sorted(tree, batch, 5), 0);
+    cr_assert_eq(contains_exactly(tree, unique, 4), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
+
+    cr_assert_eq(rb_tree_merge_sorted(tree, batch, 5), 0);
+    cr_assert_eq(contains_exactly(tree, unique, 4), 1);
+
+    rb_tree_destroy(tree);
+}
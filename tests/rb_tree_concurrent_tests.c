@@ -0,0 +1,135 @@
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+TestSuite(rb_tree_concurrent, .timeout = 20);
+
+Test(rb_tree_concurrent, behaves_like_a_set_in_one_thread)
+{
+    RB_Concurrent *tree = rb_concurrent_new();
+    cr_assert_not_null(tree);
+    RB_Reader *reader = rb_concurrent_reader(tree);
+    cr_assert_not_null(reader);
+
+    for (int i = 0; i < 500; i++)
+    {
+        cr_assert_eq(rb_concurrent_insert(tree, (i * 7) % 500), 1);
+    }
+    cr_assert_eq(rb_concurrent_insert(tree, 42), 0);
+    cr_assert_eq(rb_concurrent_size(tree), 500);
+
+    // More deletions than a retire batch
+    for (int i = 0; i < 500; i += 2)
+    {
+        cr_assert_eq(rb_concurrent_delete(tree, i), 1);
+    }
+    cr_assert_eq(rb_concurrent_delete(tree, 0), 0);
+    cr_assert_eq(rb_concurrent_size(tree), 250);
+
+    for (int i = -1; i <= 500; i++)
+    {
+        T out = -1;
+        int expected = i >= 0 && i < 500 && i % 2 == 1;
+        cr_assert_eq(rb_concurrent_find(reader, i, &out), expected,
+                     "key %d", i);
+        cr_assert_eq(out, expected ? i : -1);
+    }
+
+    // Released readers are handed out again
+    rb_concurrent_reader_release(reader);
+    cr_assert_eq(rb_concurrent_reader(tree), reader);
+
+    rb_concurrent_destroy(tree);
+}
+
+Test(rb_tree_concurrent, handles_null_arguments)
+{
+    cr_assert_null(rb_concurrent_reader(NULL));
+    cr_assert_eq(rb_concurrent_find(NULL, 1, NULL), 0);
+    cr_assert_eq(rb_concurrent_insert(NULL, 1), -1);
+    cr_assert_eq(rb_concurrent_delete(NULL, 1), -1);
+    cr_assert_eq(rb_concurrent_size(NULL), 0);
+    rb_concurrent_reader_release(NULL);
+    rb_concurrent_destroy(NULL);
+}
+
+#define STRESS_KEYS 2000
+#define STRESS_ROUNDS 40
+
+typedef struct
+{
+    RB_Concurrent *tree;
+    volatile int stop;
+    int errors;
+} Stress;
+
+/* Even keys stay in the tree while odd keys come and go: readers must always
+ * find the even ones and never anything outside the key range */
+static void *stress_reader(void *arg)
+{
+    Stress *stress = arg;
+    RB_Reader *reader = rb_concurrent_reader(stress->tree);
+    int errors = 0;
+
+    while (!stress->stop)
+    {
+        for (int i = 0; i < STRESS_KEYS; i += 2)
+        {
+            T out;
+            if (!rb_concurrent_find(reader, i, &out) || out != i)
+            {
+                errors++;
+            }
+            if (rb_concurrent_find(reader, STRESS_KEYS + i, NULL))
+            {
+                errors++;
+            }
+        }
+    }
+
+    rb_concurrent_reader_release(reader);
+    __atomic_add_fetch(&stress->errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+Test(rb_tree_concurrent, readers_run_alongside_a_writer)
+{
+    Stress stress = { rb_concurrent_new(), 0, 0 };
+    cr_assert_not_null(stress.tree);
+    for (int i = 0; i < STRESS_KEYS; i += 2)
+    {
+        rb_concurrent_insert(stress.tree, i);
+    }
+
+    pthread_t readers[3];
+    for (int i = 0; i < 3; i++)
+    {
+        cr_assert_eq(pthread_create(&readers[i], NULL, stress_reader, &stress),
+                     0);
+    }
+
+    for (int round = 0; round < STRESS_ROUNDS; round++)
+    {
+        for (int i = 1; i < STRESS_KEYS; i += 2)
+        {
+            rb_concurrent_insert(stress.tree, i);
+        }
+        for (int i = 1; i < STRESS_KEYS; i += 2)
+        {
+            rb_concurrent_delete(stress.tree, i);
+        }
+    }
+
+    stress.stop = 1;
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_join(readers[i], NULL);
+    }
+    cr_assert_eq(stress.errors, 0);
+    cr_assert_eq(rb_concurrent_size(stress.tree), STRESS_KEYS / 2);
+
+    rb_concurrent_destroy(stress.tree);
+}
@@ -0,0 +1,232 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rb_tree.h"
+#include "../rb_tree_define.h"
+
+#define INT_CMP(a, b) RB_SCALAR_CMP(a, b)
+
+static int string_cmp(const char *a, const char *b)
+{
+    return strcmp(a, b);
+}
+
+typedef struct
+{
+    long id;
+    double weight;
+} Payload;
+
+RB_TREE_DEFINE(int_map, int, int, INT_CMP)
+RB_TREE_DEFINE(str_map, const char *, Payload, string_cmp)
+
+static int int_map_black_height(int_map_tree *tree, int_map_node *node)
+{
+    if (node == &tree->nil)
+    {
+        return 1;
+    }
+
+    if ((node->left != &tree->nil && node->left->parent != node)
+        || (node->right != &tree->nil && node->right->parent != node))
+    {
+        return -1;
+    }
+
+    if (node->color == RED
+        && (node->left->color == RED || node->right->color == RED))
+    {
+        return -1;
+    }
+
+    int left = int_map_black_height(tree, node->left);
+    int right = int_map_black_height(tree, node->right);
+    if (left < 0 || left != right)
+    {
+        return -1;
+    }
+
+    return left + (node->color == BLACK ? 1 : 0);
+}
+
+static int int_map_validate(int_map_tree *tree)
+{
+    if (tree->root == &tree->nil)
+    {
+        return 1;
+    }
+    if (tree->root->parent != NULL || tree->root->color != BLACK)
+    {
+        return 0;
+    }
+    return int_map_black_height(tree, tree->root) > 0;
+}
+
+TestSuite(rb_tree_define, .timeout = 5);
+
+Test(rb_tree_define, stores_keys_and_values)
+{
+    int_map_tree *tree = int_map_new();
+    cr_assert_not_null(tree);
+
+    for (int i = 0; i < 100; i++)
+    {
+        int_map_node *node = int_map_insert(tree, i, i * 10);
+        cr_assert_not_null(node);
+        cr_assert_eq(node->key, i);
+    }
+    cr_assert_eq(int_map_size(tree), 100);
+    cr_assert_eq(int_map_validate(tree), 1);
+
+    for (int i = 0; i < 100; i++)
+    {
+        int_map_node *node = int_map_find(tree, i);
+        cr_assert_not_null(node);
+        cr_assert_eq(node->value, i * 10);
+    }
+    cr_assert_null(int_map_find(tree, 100));
+
+    int_map_destroy(tree);
+}
+
+Test(rb_tree_define, duplicate_insert_keeps_the_first_value)
+{
+    int_map_tree *tree = int_map_new();
+    cr_assert_not_null(tree);
+
+    int_map_node *first = int_map_insert(tree, 7, 1);
+    int_map_node *second = int_map_insert(tree, 7, 2);
+
+    cr_assert_eq(first, second);
+    cr_assert_eq(first->value, 1);
+    cr_assert_eq(int_map_size(tree), 1);
+
+    int_map_destroy(tree);
+}
+
+Test(rb_tree_define, find_or_insert_and_upsert_descend_once)
+{
+    int_map_tree *tree = int_map_new();
+    cr_assert_not_null(tree);
+
+    int inserted = -1;
+    int_map_node *node = int_map_find_or_insert(tree, 7, 1, &inserted);
+    cr_assert_not_null(node);
+    cr_assert_eq(inserted, 1);
+    cr_assert_eq(int_map_find_or_insert(tree, 7, 2, &inserted), node);
+    cr_assert_eq(inserted, 0);
+    cr_assert_eq(node->value, 1);
+
+    inserted = -1;
+    cr_assert_eq(int_map_upsert(tree, 7, 3, &inserted), node);
+    cr_assert_eq(inserted, 0);
+    cr_assert_eq(node->value, 3);
+    cr_assert_eq(int_map_upsert(tree, 8, 4, &inserted)->value, 4);
+    cr_assert_eq(inserted, 1);
+    cr_assert_eq(int_map_upsert(tree, 8, 5, NULL)->value, 5);
+    cr_assert_eq(int_map_size(tree), 2);
+
+    int_map_destroy(tree);
+}
+
+Test(rb_tree_define, delete_keeps_other_nodes_in_place)
+{
+    int_map_tree *tree = int_map_new();
+    cr_assert_not_null(tree);
+
+    int_map_node *nodes[64];
+    for (int i = 0; i < 64; i++)
+    {
+        nodes[i] = int_map_insert(tree, i, -i);
+    }
+
+    srand(777);
+    int removed[64] = { 0 };
+    for (int step = 0; step < 48; step++)
+    {
+        int key = rand() % 64;
+        cr_assert_eq(int_map_erase(tree, key), !removed[key]);
+        removed[key] = 1;
+        cr_assert_eq(int_map_validate(tree), 1);
+    }
+
+    for (int i = 0; i < 64; i++)
+    {
+        if (!removed[i])
+        {
+            cr_assert_eq(int_map_find(tree, i), nodes[i]);
+            cr_assert_eq(nodes[i]->value, -i);
+        }
+    }
+
+    int_map_destroy(tree);
+}
+
+Test(rb_tree_define, iterates_in_key_order_in_both_directions)
+{
+    int_map_tree *tree = int_map_new();
+    cr_assert_not_null(tree);
+
+    srand(31337);
+    for (int i = 0; i < 500; i++)
+    {
+        int_map_insert(tree, rand() % 1000, i);
+    }
+
+    size_t count = 0;
+    int previous = -1;
+    for (int_map_node *node = int_map_first(tree); node;
+         node = int_map_next(tree, node))
+    {
+        cr_assert(node->key > previous);
+        previous = node->key;
+        count++;
+    }
+    cr_assert_eq(count, int_map_size(tree));
+
+    previous = 1000;
+    for (int_map_node *node = int_map_last(tree); node;
+         node = int_map_prev(tree, node))
+    {
+        cr_assert(node->key < previous);
+        previous = node->key;
+        count--;
+    }
+    cr_assert_eq(count, 0);
+
+    int_map_destroy(tree);
+}
+
+Test(rb_tree_define, several_instantiations_live_side_by_side)
+{
+    str_map_tree *names = str_map_new();
+    int_map_tree *numbers = int_map_new();
+    cr_assert_not_null(names);
+    cr_assert_not_null(numbers);
+
+    const char *words[] = { "pear", "apple", "fig", "kiwi", "banana" };
+    for (int i = 0; i < 5; i++)
+    {
+        Payload payload = { i, i * 0.5 };
+        str_map_insert(names, words[i], payload);
+        int_map_insert(numbers, i, i);
+    }
+
+    char key[16];
+    strcpy(key, "fig");
+    str_map_node *fig = str_map_find(names, key);
+    cr_assert_not_null(fig);
+    cr_assert_eq(fig->value.id, 2);
+
+    cr_assert_eq(strcmp(str_map_first(names)->key, "apple"), 0);
+    cr_assert_eq(strcmp(str_map_last(names)->key, "pear"), 0);
+    cr_assert_eq(str_map_erase(names, "kiwi"), 1);
+    cr_assert_eq(str_map_erase(names, "kiwi"), 0);
+    cr_assert_eq(str_map_size(names), 4);
+    cr_assert_eq(int_map_size(numbers), 5);
+
+    str_map_destroy(names);
+    int_map_destroy(numbers);
+}
@@ -0,0 +1,163 @@
+#include <criterion/criterion.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+/* Compare every lookup of the snapshot with the same lookup in the tree, for
+ * keys around and between the stored ones */
+static void check_snapshot(RB_Tree *tree, RB_FrozenBlocks *frozen, int lo,
+                           int hi)
+{
+    cr_assert_eq(rb_frozen_blocks_size(frozen), rb_tree_size(tree));
+    for (int key = lo; key <= hi; key++)
+    {
+        RB_Node *node = rb_find(tree, key);
+        const T *found = rb_frozen_blocks_find(frozen, key);
+        if (node)
+        {
+            cr_assert_not_null(found, "key %d not found", key);
+            cr_assert_eq(*found, key);
+        }
+        else
+        {
+            cr_assert_null(found, "key %d found", key);
+        }
+
+        node = rb_lower_bound(tree, key);
+        const T *bound = rb_frozen_blocks_lower_bound(frozen, key);
+        if (node)
+        {
+            cr_assert_not_null(bound, "no lower bound for %d", key);
+            cr_assert_eq(*bound, node->data);
+        }
+        else
+        {
+            cr_assert_null(bound, "lower bound for %d", key);
+        }
+    }
+}
+
+TestSuite(rb_tree_frozen_blocks, .timeout = 5);
+
+Test(rb_tree_frozen_blocks, matches_the_tree_for_every_size)
+{
+    // Sizes up to three levels of blocks, with partial last blocks
+    for (int n = 0; n <= 320; n++)
+    {
+        RB_Tree *tree = rb_tree_new();
+        cr_assert_not_null(tree);
+        for (int i = 0; i < n; i++)
+        {
+            rb_insert(tree, 3 * i);
+        }
+
+        RB_FrozenBlocks *frozen = rb_tree_freeze_blocks(tree);
+        cr_assert_not_null(frozen);
+        check_snapshot(tree, frozen, -2, 3 * n + 2);
+
+        rb_frozen_blocks_destroy(frozen);
+        rb_tree_destroy(tree);
+    }
+}
+
+Test(rb_tree_frozen_blocks, compares_extreme_and_negative_keys)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int keys[] = { INT_MIN, INT_MIN + 1, -1000, -1, 0, 1, 1000, INT_MAX - 1 };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+    {
+        rb_insert(tree, keys[i]);
+    }
+
+    RB_FrozenBlocks *frozen = rb_tree_freeze_blocks(tree);
+    cr_assert_not_null(frozen);
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+    {
+        const T *found = rb_frozen_blocks_find(frozen, keys[i]);
+        cr_assert_not_null(found);
+        cr_assert_eq(*found, keys[i]);
+    }
+    cr_assert_null(rb_frozen_blocks_find(frozen, INT_MAX));
+    cr_assert_null(rb_frozen_blocks_lower_bound(frozen, INT_MAX));
+    cr_assert_eq(*rb_frozen_blocks_lower_bound(frozen, -999), -1);
+
+    // INT_MAX also pads the last block
+    rb_insert(tree, INT_MAX);
+    cr_assert_eq(rb_frozen_blocks_refresh(frozen, tree), 0);
+    cr_assert_eq(*rb_frozen_blocks_find(frozen, INT_MAX), INT_MAX);
+    check_snapshot(tree, frozen, -1010, 1010);
+
+    rb_frozen_blocks_destroy(frozen);
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_frozen_blocks, reports_its_instruction_set)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    RB_FrozenBlocks *frozen = rb_tree_freeze_blocks(tree);
+    cr_assert_not_null(frozen);
+    cr_assert_not_null(rb_frozen_blocks_isa(frozen));
+    cr_assert_null(rb_frozen_blocks_isa(NULL));
+
+    rb_frozen_blocks_destroy(frozen);
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_frozen_blocks, refreshes_after_changes)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 100; i++)
+    {
+        rb_insert(tree, (i * 53) % 100);
+    }
+
+    RB_FrozenBlocks *frozen = rb_tree_freeze_blocks(tree);
+    cr_assert_not_null(frozen);
+
+    // The snapshot does not see changes until it is refreshed
+    rb_delete(tree, rb_find(tree, 50));
+    cr_assert_not_null(rb_frozen_blocks_find(frozen, 50));
+    cr_assert_eq(rb_frozen_blocks_refresh(frozen, tree), 0);
+    cr_assert_null(rb_frozen_blocks_find(frozen, 50));
+    check_snapshot(tree, frozen, -1, 101);
+
+    // Unchanged trees keep their snapshot
+    cr_assert_eq(rb_frozen_blocks_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 101);
+
+    // Growing past the capacity of the snapshot
+    for (int i = 100; i < 300; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(rb_frozen_blocks_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 301);
+
+    // Shrinking to nothing
+    while (rb_first(tree))
+    {
+        rb_delete(tree, rb_first(tree));
+    }
+    cr_assert_eq(rb_frozen_blocks_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 301);
+
+    rb_frozen_blocks_destroy(frozen);
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_frozen_blocks, handles_null_arguments)
+{
+    cr_assert_null(rb_tree_freeze_blocks(NULL));
+    cr_assert_eq(rb_frozen_blocks_refresh(NULL, NULL), -1);
+    cr_assert_null(rb_frozen_blocks_find(NULL, 1));
+    cr_assert_null(rb_frozen_blocks_lower_bound(NULL, 1));
+    cr_assert_eq(rb_frozen_blocks_size(NULL), 0);
+    rb_frozen_blocks_destroy(NULL);
+}
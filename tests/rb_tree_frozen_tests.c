@@ -0,0 +1,114 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+/* Compare every lookup of the snapshot with the same lookup in the tree, for
+ * keys around and between the stored ones */
+static void check_snapshot(RB_Tree *tree, RB_Frozen *frozen, int lo, int hi)
+{
+    cr_assert_eq(rb_frozen_size(frozen), rb_tree_size(tree));
+    for (int key = lo; key <= hi; key++)
+    {
+        RB_Node *node = rb_find(tree, key);
+        const T *found = rb_frozen_find(frozen, key);
+        if (node)
+        {
+            cr_assert_not_null(found, "key %d not found", key);
+            cr_assert_eq(*found, key);
+        }
+        else
+        {
+            cr_assert_null(found, "key %d found", key);
+        }
+
+        node = rb_lower_bound(tree, key);
+        const T *bound = rb_frozen_lower_bound(frozen, key);
+        if (node)
+        {
+            cr_assert_not_null(bound, "no lower bound for %d", key);
+            cr_assert_eq(*bound, node->data);
+        }
+        else
+        {
+            cr_assert_null(bound, "lower bound for %d", key);
+        }
+    }
+}
+
+TestSuite(rb_tree_frozen, .timeout = 5);
+
+Test(rb_tree_frozen, matches_the_tree_for_every_size)
+{
+    // Sizes around powers of two exercise partial last levels
+    for (int n = 0; n <= 70; n++)
+    {
+        RB_Tree *tree = rb_tree_new();
+        cr_assert_not_null(tree);
+        for (int i = 0; i < n; i++)
+        {
+            rb_insert(tree, 3 * i);
+        }
+
+        RB_Frozen *frozen = rb_tree_freeze(tree);
+        cr_assert_not_null(frozen);
+        check_snapshot(tree, frozen, -2, 3 * n + 2);
+
+        rb_frozen_destroy(frozen);
+        rb_tree_destroy(tree);
+    }
+}
+
+Test(rb_tree_frozen, refreshes_after_changes)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 100; i++)
+    {
+        rb_insert(tree, (i * 37) % 100);
+    }
+
+    RB_Frozen *frozen = rb_tree_freeze(tree);
+    cr_assert_not_null(frozen);
+
+    // The snapshot does not see changes until it is refreshed
+    rb_delete(tree, rb_find(tree, 50));
+    cr_assert_not_null(rb_frozen_find(frozen, 50));
+    cr_assert_eq(rb_frozen_refresh(frozen, tree), 0);
+    cr_assert_null(rb_frozen_find(frozen, 50));
+    check_snapshot(tree, frozen, -1, 101);
+
+    // Unchanged trees keep their snapshot
+    cr_assert_eq(rb_frozen_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 101);
+
+    // Growing past the capacity of the snapshot
+    for (int i = 100; i < 300; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(rb_frozen_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 301);
+
+    // Shrinking to nothing
+    while (rb_first(tree))
+    {
+        rb_delete(tree, rb_first(tree));
+    }
+    cr_assert_eq(rb_frozen_refresh(frozen, tree), 0);
+    check_snapshot(tree, frozen, -1, 301);
+
+    rb_frozen_destroy(frozen);
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_frozen, handles_null_arguments)
+{
+    cr_assert_null(rb_tree_freeze(NULL));
+    cr_assert_eq(rb_frozen_refresh(NULL, NULL), -1);
+    cr_assert_null(rb_frozen_find(NULL, 1));
+    cr_assert_null(rb_frozen_lower_bound(NULL, 1));
+    cr_assert_eq(rb_frozen_size(NULL), 0);
+    rb_frozen_destroy(NULL);
+}
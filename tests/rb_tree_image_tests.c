@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+/* Temporary file holding an image of the keys 0, 3, 6... */
+static FILE *image_of_multiples(size_t n)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    for (size_t i = 0; i < n; i++)
+    {
+        rb_insert(tree, (int)(3 * i));
+    }
+
+    FILE *file = tmpfile();
+    cr_assert_not_null(file);
+    cr_assert_eq(rb_tree_save(tree, fileno(file)), 0);
+    cr_assert_eq(lseek(fileno(file), 0, SEEK_SET), 0);
+    rb_tree_destroy(tree);
+    return file;
+}
+
+/* Temporary file holding the given raw bytes */
+static FILE *file_of(const void *bytes, size_t length)
+{
+    FILE *file = tmpfile();
+    cr_assert_not_null(file);
+    cr_assert_eq(write(fileno(file), bytes, length), (ssize_t)length);
+    cr_assert_eq(lseek(fileno(file), 0, SEEK_SET), 0);
+    return file;
+}
+
+TestSuite(rb_tree_image, .timeout = 10);
+
+Test(rb_tree_image, load_rebuilds_the_saved_tree)
+{
+    size_t sizes[] = { 0, 1, 2, 3, 1023, 1024, 1025, 5000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        FILE *file = image_of_multiples(sizes[s]);
+        RB_Tree *tree = rb_tree_load(fileno(file));
+        cr_assert_not_null(tree);
+        cr_assert(rb_test_validate(tree));
+        cr_assert_eq(rb_tree_size(tree), sizes[s]);
+
+        size_t i = 0;
+        for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+        {
+            cr_assert_eq(node->data, (int)(3 * i++));
+        }
+        cr_assert_eq(i, sizes[s]);
+
+        // A loaded tree is an ordinary tree
+        cr_assert_not_null(rb_insert(tree, -1));
+        cr_assert(rb_test_validate(tree));
+
+        rb_tree_destroy(tree);
+        fclose(file);
+    }
+}
+
+Test(rb_tree_image, load_reads_from_a_pipe)
+{
+    int fds[2];
+    cr_assert_eq(pipe(fds), 0);
+
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 100; i++)
+    {
+        rb_insert(tree, i);
+    }
+    cr_assert_eq(rb_tree_save(tree, fds[1]), 0);
+    close(fds[1]);
+    rb_tree_destroy(tree);
+
+    tree = rb_tree_load(fds[0]);
+    close(fds[0]);
+    cr_assert_not_null(tree);
+    cr_assert(rb_test_validate(tree));
+    cr_assert_eq(rb_tree_size(tree), 100);
+    cr_assert_not_null(rb_find(tree, 99));
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_image, map_serves_lookups_from_the_file)
+{
+    FILE *file = image_of_multiples(5000);
+    RB_Mapped *mapped = rb_tree_map(fileno(file));
+    fclose(file);
+    cr_assert_not_null(mapped);
+    cr_assert_eq(rb_mapped_size(mapped), 5000);
+
+    for (int i = -1; i < 3 * 5000; i++)
+    {
+        const int *key = rb_mapped_lower_bound(mapped, i);
+        if (i > 3 * 4999)
+        {
+            cr_assert_null(key);
+            continue;
+        }
+        int expected = i < 0 ? 0 : (i + 2) / 3 * 3;
+        cr_assert_not_null(key);
+        cr_assert_eq(*key, expected);
+
+        const int *found = rb_mapped_find(mapped, i);
+        if (i >= 0 && i % 3 == 0)
+        {
+            cr_assert_eq(found, key);
+        }
+        else
+        {
+            cr_assert_null(found);
+        }
+    }
+    rb_mapped_destroy(mapped);
+
+    file = image_of_multiples(0);
+    mapped = rb_tree_map(fileno(file));
+    fclose(file);
+    cr_assert_not_null(mapped);
+    cr_assert_eq(rb_mapped_size(mapped), 0);
+    cr_assert_null(rb_mapped_lower_bound(mapped, 0));
+    rb_mapped_destroy(mapped);
+}
+
+Test(rb_tree_image, rejects_invalid_images)
+{
+    FILE *file = image_of_multiples(10);
+    unsigned char image[32 + 10 * sizeof(int)];
+    cr_assert_eq(read(fileno(file), image, sizeof(image)),
+                 (ssize_t)sizeof(image));
+    fclose(file);
+
+    unsigned char bad[sizeof(image)];
+    size_t fields[] = { 0, 8, 12, 16 };
+    for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+    {
+        // Magic, version, byte order and key size
+        memcpy(bad, image, sizeof(image));
+        bad[fields[f]] ^= 0x40;
+        file = file_of(bad, sizeof(bad));
+        cr_assert_null(rb_tree_load(fileno(file)));
+        cr_assert_null(rb_tree_map(fileno(file)));
+        fclose(file);
+    }
+
+    // Truncated
+    file = file_of(image, sizeof(image) - 1);
+    cr_assert_null(rb_tree_load(fileno(file)));
+    cr_assert_null(rb_tree_map(fileno(file)));
+    fclose(file);
+
+    // Out of order
+    memcpy(bad, image, sizeof(image));
+    memcpy(bad + 32, image + 36, sizeof(int));
+    memcpy(bad + 36, image + 32, sizeof(int));
+    file = file_of(bad, sizeof(bad));
+    cr_assert_null(rb_tree_load(fileno(file)));
+    fclose(file);
+
+    // Mapping needs a regular file
+    int fds[2];
+    cr_assert_eq(pipe(fds), 0);
+    cr_assert_null(rb_tree_map(fds[0]));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+Test(rb_tree_image, handles_null_arguments)
+{
+    cr_assert_eq(rb_tree_save(NULL, 1), -1);
+    cr_assert_null(rb_mapped_find(NULL, 0));
+    cr_assert_null(rb_mapped_lower_bound(NULL, 0));
+    cr_assert_eq(rb_mapped_size(NULL), 0);
+    rb_mapped_destroy(NULL);
+}
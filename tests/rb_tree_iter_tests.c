@@ -0,0 +1,101 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+TestSuite(rb_tree_iter, .timeout = 5);
+
+Test(rb_tree_iter, empty_tree_has_no_first_or_last)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    cr_assert_null(rb_first(tree));
+    cr_assert_null(rb_last(tree));
+    cr_assert_null(rb_first(NULL));
+    cr_assert_null(rb_next(tree, NULL));
+    cr_assert_null(rb_prev(tree, &tree->nil));
+
+    RB_Cursor cursor;
+    rb_cursor_first(&cursor, tree);
+    cr_assert_null(cursor.node);
+    cr_assert_null(rb_cursor_next(&cursor));
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_iter, walks_in_order_in_both_directions)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    srand(1234);
+    for (int i = 0; i < 1000; i++)
+    {
+        rb_insert(tree, rand() % 5000);
+    }
+
+    size_t count = 0;
+    RB_Node *previous = NULL;
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        if (previous)
+        {
+            cr_assert(previous->data < node->data);
+            cr_assert_eq(rb_prev(tree, node), previous);
+        }
+        previous = node;
+        count++;
+    }
+    cr_assert_eq(count, rb_tree_size(tree));
+    cr_assert_eq(previous, rb_last(tree));
+
+    for (RB_Node *node = rb_last(tree); node; node = rb_prev(tree, node))
+    {
+        count--;
+    }
+    cr_assert_eq(count, 0);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_iter, cursor_survives_unrelated_inserts)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    for (int i = 0; i < 100; i += 10)
+    {
+        rb_insert(tree, i);
+    }
+
+    RB_Cursor cursor;
+    rb_cursor_first(&cursor, tree);
+    cr_assert_eq(cursor.node->data, 0);
+    cr_assert_eq(rb_cursor_next(&cursor)->data, 10);
+
+    // Rotations triggered here must not disturb the cursor
+    for (int i = 11; i < 20; i++)
+    {
+        rb_insert(tree, i);
+    }
+    for (int i = 100; i < 200; i++)
+    {
+        rb_insert(tree, i);
+    }
+
+    cr_assert_eq(cursor.node->data, 10);
+    for (int i = 11; i < 20; i++)
+    {
+        cr_assert_eq(rb_cursor_next(&cursor)->data, i);
+    }
+    cr_assert_eq(rb_cursor_next(&cursor)->data, 20);
+    cr_assert_eq(rb_cursor_prev(&cursor)->data, 19);
+
+    rb_cursor_last(&cursor, tree);
+    cr_assert_eq(cursor.node->data, 199);
+    cr_assert_null(rb_cursor_next(&cursor));
+
+    rb_tree_destroy(tree);
+}
@@ -0,0 +1,139 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+#ifdef RB_ORDER_STATISTICS
+
+static size_t check_sizes(RB_Tree *tree, RB_Node *node, int *ok)
+{
+    if (node == &tree->nil)
+    {
+        return 0;
+    }
+
+    size_t size = check_sizes(tree, node->left, ok)
+        + check_sizes(tree, node->right, ok) + 1;
+    if (node->size != size)
+    {
+        *ok = 0;
+    }
+    return size;
+}
+
+static int sizes_are_consistent(RB_Tree *tree)
+{
+    int ok = tree->nil.size == 0;
+    check_sizes(tree, tree->root, &ok);
+    return ok;
+}
+
+TestSuite(rb_tree_order, .timeout = 5);
+
+Test(rb_tree_order, empty_tree_has_no_ranks)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    cr_assert_null(rb_select(tree, 0));
+    cr_assert_eq(rb_rank(tree, 42), 0);
+    cr_assert_null(rb_select(NULL, 0));
+    cr_assert_eq(rb_rank(NULL, 42), 0);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_order, select_and_rank_follow_the_sorted_order)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    // Insert multiples of 3 in a scrambled order
+    for (int i = 0; i < 300; i++)
+    {
+        rb_insert(tree, ((i * 7919) % 300) * 3);
+    }
+    rb_insert(tree, 0);
+    cr_assert_eq(sizes_are_consistent(tree), 1);
+    cr_assert_eq(tree->root->size, 300);
+
+    for (size_t k = 0; k < 300; k++)
+    {
+        RB_Node *node = rb_select(tree, k);
+        cr_assert_not_null(node);
+        cr_assert_eq(node->data, (int)k * 3);
+        cr_assert_eq(rb_rank(tree, (int)k * 3), k);
+        cr_assert_eq(rb_rank(tree, (int)k * 3 + 1), k + 1);
+    }
+    cr_assert_null(rb_select(tree, 300));
+    cr_assert_eq(rb_rank(tree, -1), 0);
+    cr_assert_eq(rb_rank(tree, 100000), 300);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_order, sizes_survive_random_deletions)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(0);
+    cr_assert_not_null(tree);
+
+    int present[1000] = { 0 };
+    srand(2024);
+    for (int step = 0; step < 4000; step++)
+    {
+        int value = rand() % 1000;
+        RB_Node *node = rb_find(tree, value);
+        if (node)
+        {
+            rb_delete(tree, node);
+            present[value] = 0;
+        }
+        else
+        {
+            rb_insert(tree, value);
+            present[value] = 1;
+        }
+
+        if (step % 97 == 0)
+        {
+            cr_assert_eq(sizes_are_consistent(tree), 1, "step %d", step);
+        }
+    }
+    cr_assert_eq(sizes_are_consistent(tree), 1);
+
+    size_t rank = 0;
+    for (int value = 0; value < 1000; value++)
+    {
+        cr_assert_eq(rb_rank(tree, value), rank);
+        if (present[value])
+        {
+            cr_assert_eq(rb_select(tree, rank)->data, value);
+            rank++;
+        }
+    }
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_order, built_and_merged_trees_have_sizes)
+{
+    int keys[200];
+    for (int i = 0; i < 200; i++)
+    {
+        keys[i] = i * 2;
+    }
+
+    RB_Tree *tree = rb_tree_build_sorted(keys, 100);
+    cr_assert_not_null(tree);
+    cr_assert_eq(sizes_are_consistent(tree), 1);
+    cr_assert_eq(rb_select(tree, 99)->data, 198);
+
+    cr_assert_eq(rb_tree_merge_sorted(tree, keys + 50, 150), 0);
+    cr_assert_eq(sizes_are_consistent(tree), 1);
+    cr_assert_eq(rb_rank(tree, 201), 101);
+
+    rb_tree_destroy(tree);
+}
+
+#endif // RB_ORDER_STATISTICS
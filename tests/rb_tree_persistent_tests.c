@@ -0,0 +1,210 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/rb_tree_internal.h"
+
+/* Black height of a persistent subtree, or -1 when it breaks a red black
+ * rule, is out of order or has a node nobody references */
+static int pnode_black_height(const RB_PNode *node, const T *lo, const T *hi)
+{
+    if (!node)
+    {
+        return 1;
+    }
+    if (node->refs == 0 || (lo && node->data <= *lo)
+        || (hi && node->data >= *hi))
+    {
+        return -1;
+    }
+    if (node->color == RED
+        && ((node->left && node->left->color == RED)
+            || (node->right && node->right->color == RED)))
+    {
+        return -1;
+    }
+
+    int left = pnode_black_height(node->left, lo, &node->data);
+    int right = pnode_black_height(node->right, &node->data, hi);
+    if (left < 0 || left != right)
+    {
+        return -1;
+    }
+    return left + (node->color == BLACK);
+}
+
+static void check_version(const RB_PNode *root)
+{
+    cr_assert(!root || root->color == BLACK);
+    cr_assert_geq(pnode_black_height(root, NULL, NULL), 0);
+}
+
+typedef struct
+{
+    int values[1024];
+    size_t count;
+} Collector;
+
+static int collect(T data, void *ctx)
+{
+    Collector *collector = ctx;
+    collector->values[collector->count++] = data;
+    return 0;
+}
+
+static int stop_at_three(T data, void *ctx)
+{
+    (void)data;
+    return ++*(int *)ctx == 3;
+}
+
+TestSuite(rb_tree_persistent, .timeout = 10);
+
+Test(rb_tree_persistent, stays_balanced_through_inserts_and_deletes)
+{
+    RB_Persistent *tree = rb_persistent_new();
+    cr_assert_not_null(tree);
+    int present[1000] = { 0 };
+
+    srand(7);
+    for (int i = 0; i < 5000; i++)
+    {
+        int key = rand() % 1000;
+        if (rand() % 3)
+        {
+            cr_assert_eq(rb_persistent_insert(tree, key), !present[key]);
+            present[key] = 1;
+        }
+        else
+        {
+            cr_assert_eq(rb_persistent_delete(tree, key), present[key]);
+            present[key] = 0;
+        }
+        check_version(tree->root);
+    }
+
+    size_t expected = 0;
+    for (int key = 0; key < 1000; key++)
+    {
+        T out = -1;
+        cr_assert_eq(rb_persistent_find(tree, key, &out), present[key]);
+        cr_assert_eq(out, present[key] ? key : -1);
+        expected += present[key];
+    }
+    cr_assert_eq(rb_persistent_size(tree), expected);
+
+    rb_persistent_destroy(tree);
+}
+
+Test(rb_tree_persistent, deletions_keep_few_spares)
+{
+    RB_Persistent *tree = rb_persistent_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 100000; i++)
+    {
+        cr_assert_eq(rb_persistent_insert(tree, i), 1);
+    }
+
+    // A deletion from 100000 nodes needs at most 4 * 34 + 4 spares, the
+    // nodes deleted beyond that are freed
+    for (int i = 0; i < 100000; i++)
+    {
+        cr_assert_eq(rb_persistent_delete(tree, i), 1);
+        cr_assert_leq(tree->spare_count, 140);
+    }
+    cr_assert_eq(rb_persistent_size(tree), 0);
+
+    rb_persistent_destroy(tree);
+}
+
+Test(rb_tree_persistent, snapshots_do_not_see_later_changes)
+{
+    RB_Persistent *tree = rb_persistent_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 200; i++)
+    {
+        rb_persistent_insert(tree, i);
+    }
+
+    RB_Snapshot *before = rb_persistent_snapshot(tree);
+    cr_assert_not_null(before);
+    for (int i = 0; i < 200; i += 2)
+    {
+        cr_assert_eq(rb_persistent_delete(tree, i), 1);
+        check_version(tree->root);
+        check_version(before->root);
+    }
+    for (int i = 200; i < 300; i++)
+    {
+        rb_persistent_insert(tree, i);
+    }
+    RB_Snapshot *after = rb_persistent_snapshot(tree);
+    cr_assert_not_null(after);
+
+    // The tree goes on changing while both versions stay as they were
+    for (int i = 0; i < 300; i++)
+    {
+        rb_persistent_delete(tree, i);
+    }
+    cr_assert_eq(rb_persistent_size(tree), 0);
+
+    Collector old = { { 0 }, 0 };
+    cr_assert_eq(rb_snapshot_size(before), 200);
+    cr_assert_eq(rb_snapshot_visit(before, collect, &old), 200);
+    for (int i = 0; i < 200; i++)
+    {
+        cr_assert_eq(old.values[i], i);
+        cr_assert(rb_snapshot_find(before, i, NULL));
+    }
+
+    Collector recent = { { 0 }, 0 };
+    cr_assert_eq(rb_snapshot_size(after), 200);
+    cr_assert_eq(rb_snapshot_visit(after, collect, &recent), 200);
+    for (int i = 0; i < 200; i++)
+    {
+        int expected = i < 100 ? 2 * i + 1 : 100 + i;
+        cr_assert_eq(recent.values[i], expected);
+    }
+    T out = -1;
+    cr_assert(rb_snapshot_find(after, 250, &out));
+    cr_assert_eq(out, 250);
+    cr_assert_not(rb_snapshot_find(after, 100, NULL));
+
+    rb_snapshot_release(before);
+    check_version(after->root);
+    rb_snapshot_release(after);
+    rb_persistent_destroy(tree);
+}
+
+Test(rb_tree_persistent, snapshots_outlive_their_tree)
+{
+    RB_Persistent *tree = rb_persistent_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 10; i++)
+    {
+        rb_persistent_insert(tree, i);
+    }
+
+    RB_Snapshot *snapshot = rb_persistent_snapshot(tree);
+    cr_assert_not_null(snapshot);
+    rb_persistent_destroy(tree);
+
+    int visited = 0;
+    cr_assert_eq(rb_snapshot_visit(snapshot, stop_at_three, &visited), 3);
+    cr_assert(rb_snapshot_find(snapshot, 9, NULL));
+    rb_snapshot_release(snapshot);
+}
+
+Test(rb_tree_persistent, handles_null_arguments)
+{
+    cr_assert_eq(rb_persistent_insert(NULL, 1), -1);
+    cr_assert_eq(rb_persistent_delete(NULL, 1), -1);
+    cr_assert_eq(rb_persistent_find(NULL, 1, NULL), 0);
+    cr_assert_eq(rb_persistent_size(NULL), 0);
+    cr_assert_null(rb_persistent_snapshot(NULL));
+    cr_assert_eq(rb_snapshot_find(NULL, 1, NULL), 0);
+    cr_assert_eq(rb_snapshot_size(NULL), 0);
+    cr_assert_eq(rb_snapshot_visit(NULL, collect, NULL), 0);
+    rb_snapshot_release(NULL);
+    rb_persistent_destroy(NULL);
+}
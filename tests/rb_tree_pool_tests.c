@@ -0,0 +1,122 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+TestSuite(rb_tree_pool, .timeout = 5);
+
+Test(rb_tree_pool, should_create_a_pooled_tree)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(16);
+
+    cr_assert_not_null(tree);
+    cr_assert_not_null(tree->pool);
+    cr_assert_eq(tree->root, &tree->nil);
+    cr_assert_eq(rb_color(&tree->nil), BLACK);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_pool, rejects_a_reserve_too_large_to_allocate)
+{
+    // Unchecked, the size of the slab would wrap around to a small one
+    cr_assert_null(rb_tree_new_with_pool(SIZE_MAX / sizeof(RB_Node) + 1));
+    cr_assert_null(rb_tree_new_with_pool(SIZE_MAX));
+}
+
+Test(rb_tree_pool, reserved_nodes_are_contiguous)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(8);
+    cr_assert_not_null(tree);
+
+    RB_Node *first = rb_insert(tree, 0);
+    for (int i = 1; i < 8; i++)
+    {
+        RB_Node *node = rb_insert(tree, i);
+        cr_assert_eq(node, first + i);
+    }
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_pool, deleted_nodes_are_recycled)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(0);
+    cr_assert_not_null(tree);
+
+    for (int i = 0; i < 10; i++)
+    {
+        rb_insert(tree, i);
+    }
+
+    RB_Node *leaf = rb_find(tree, 9);
+    cr_assert_not_null(leaf);
+    rb_delete(tree, leaf);
+
+    RB_Node *node = rb_insert(tree, 100);
+    cr_assert_eq(node, leaf);
+    cr_assert_eq(node->data, 100);
+    cr_assert_eq(rb_test_validate(tree), 1);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_pool, grows_past_the_reserve_and_stays_valid)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(4);
+    cr_assert_not_null(tree);
+
+    srand(4242);
+    for (int i = 0; i < 5000; i++)
+    {
+        int value = rand() % 2000;
+        RB_Node *node = rb_find(tree, value);
+        if (node)
+        {
+            rb_delete(tree, node);
+        }
+        else
+        {
+            cr_assert_not_null(rb_insert(tree, value));
+        }
+    }
+    cr_assert_eq(rb_test_validate(tree), 1);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        RB_Node *node = rb_find(tree, i);
+        if (node)
+        {
+            cr_assert_eq(node->data, i);
+        }
+    }
+
+    rb_tree_destroy(tree);
+}
+
+static void sum_data(T data, void *ctx)
+{
+    long *sum = ctx;
+    *sum += data;
+}
+
+Test(rb_tree_pool, destroy_with_calls_the_destructor_on_pooled_nodes)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(0);
+    cr_assert_not_null(tree);
+
+    long expected = 0;
+    for (int i = 1; i <= 1000; i++)
+    {
+        rb_insert(tree, i);
+        expected += i;
+    }
+    rb_delete(tree, rb_find(tree, 500));
+    expected -= 500;
+
+    long sum = 0;
+    rb_tree_destroy_with(tree, sum_data, &sum);
+    cr_assert_eq(sum, expected);
+}
@@ -0,0 +1,104 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+typedef struct
+{
+    int values[128];
+    size_t count;
+    size_t limit;
+} Collector;
+
+static int collect(RB_Node *node, void *ctx)
+{
+    Collector *collector = ctx;
+    collector->values[collector->count++] = node->data;
+    return collector->count == collector->limit;
+}
+
+static RB_Tree *tree_of_multiples_of_ten(void)
+{
+    RB_Tree *tree = rb_tree_new();
+    for (int i = 9; i >= 0; i--)
+    {
+        rb_insert(tree, i * 10);
+    }
+    return tree;
+}
+
+TestSuite(rb_tree_range, .timeout = 3);
+
+Test(rb_tree_range, bounds_on_an_empty_tree_are_null)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    cr_assert_null(rb_lower_bound(tree, 1));
+    cr_assert_null(rb_upper_bound(tree, 1));
+    cr_assert_null(rb_floor(tree, 1));
+    cr_assert_null(rb_ceil(tree, 1));
+    cr_assert_null(rb_lower_bound(NULL, 1));
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_range, bounds_find_the_neighbouring_keys)
+{
+    RB_Tree *tree = tree_of_multiples_of_ten();
+    cr_assert_not_null(tree);
+
+    cr_assert_eq(rb_lower_bound(tree, 30)->data, 30);
+    cr_assert_eq(rb_lower_bound(tree, 31)->data, 40);
+    cr_assert_eq(rb_lower_bound(tree, -5)->data, 0);
+    cr_assert_null(rb_lower_bound(tree, 91));
+
+    cr_assert_eq(rb_upper_bound(tree, 30)->data, 40);
+    cr_assert_eq(rb_upper_bound(tree, 29)->data, 30);
+    cr_assert_null(rb_upper_bound(tree, 90));
+
+    cr_assert_eq(rb_floor(tree, 30)->data, 30);
+    cr_assert_eq(rb_floor(tree, 39)->data, 30);
+    cr_assert_eq(rb_floor(tree, 1000)->data, 90);
+    cr_assert_null(rb_floor(tree, -1));
+
+    cr_assert_eq(rb_ceil(tree, 55)->data, 60);
+    cr_assert_eq(rb_ceil(tree, 60)->data, 60);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_range, range_visits_half_open_interval_in_order)
+{
+    RB_Tree *tree = tree_of_multiples_of_ten();
+    cr_assert_not_null(tree);
+
+    Collector collector = { { 0 }, 0, 0 };
+    cr_assert_eq(rb_range(tree, 20, 60, collect, &collector), 4);
+    cr_assert_eq(collector.count, 4);
+    for (size_t i = 0; i < 4; i++)
+    {
+        cr_assert_eq(collector.values[i], 20 + (int)i * 10);
+    }
+
+    collector.count = 0;
+    cr_assert_eq(rb_range(tree, 15, 16, collect, &collector), 0);
+    cr_assert_eq(rb_range(tree, 60, 20, collect, &collector), 0);
+    cr_assert_eq(rb_range(tree, -100, 1000, collect, &collector), 10);
+    cr_assert_eq(rb_range(tree, 0, 10, NULL, NULL), 0);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_range, callback_can_stop_the_visit)
+{
+    RB_Tree *tree = tree_of_multiples_of_ten();
+    cr_assert_not_null(tree);
+
+    Collector collector = { { 0 }, 0, 3 };
+    cr_assert_eq(rb_range(tree, 0, 100, collect, &collector), 3);
+    cr_assert_eq(collector.values[2], 20);
+
+    rb_tree_destroy(tree);
+}
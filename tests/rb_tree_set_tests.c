@@ -0,0 +1,253 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+#define UNIVERSE 20000
+
+/* Whether tree is a valid red black tree holding exactly the keys k for
+ * which member[k] is set */
+static int holds(RB_Tree *tree, const char *member)
+{
+    if (!rb_test_validate(tree))
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    int previous = -1;
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        if (node->data <= previous || node->data >= UNIVERSE
+            || !member[node->data])
+        {
+            return 0;
+        }
+        previous = node->data;
+        count++;
+    }
+    size_t expected = 0;
+    for (int k = 0; k < UNIVERSE; k++)
+    {
+        expected += member[k] != 0;
+    }
+    return count == expected && rb_tree_size(tree) == expected;
+}
+
+/* Tree of about n random keys below limit, whose keys are set in member */
+static RB_Tree *random_tree(size_t n, int limit, char *member,
+                            unsigned *seed)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    memset(member, 0, UNIVERSE);
+    for (size_t i = 0; i < n; i++)
+    {
+        *seed = *seed * 1103515245u + 12345u;
+        int key = (int)((*seed >> 8) % (unsigned)limit);
+        cr_assert_not_null(rb_insert(tree, key));
+        member[key] = 1;
+    }
+    return tree;
+}
+
+typedef RB_Tree *(*SetOperation)(RB_Tree *, RB_Tree *, unsigned);
+
+static void check(SetOperation operation, size_t n, size_t m, int limit,
+                  unsigned threads, unsigned *seed)
+{
+    static char in_a[UNIVERSE];
+    static char in_b[UNIVERSE];
+    static char expected[UNIVERSE];
+
+    RB_Tree *a = random_tree(n, limit, in_a, seed);
+    RB_Tree *b = random_tree(m, limit, in_b, seed);
+    for (int k = 0; k < UNIVERSE; k++)
+    {
+        expected[k] = operation == rb_union     ? in_a[k] || in_b[k]
+                    : operation == rb_intersect ? in_a[k] && in_b[k]
+                                                : in_a[k] && !in_b[k];
+    }
+
+    RB_Tree *result = operation(a, b, threads);
+    cr_assert(result == a || result == b);
+    cr_assert(holds(result, expected), "n=%zu m=%zu limit=%d threads=%u", n,
+              m, limit, threads);
+    rb_tree_destroy(result);
+}
+
+TestSuite(rb_tree_set, .timeout = 60);
+
+Test(rb_tree_set, matches_the_reference_for_any_sizes)
+{
+    SetOperation operations[] = { rb_union, rb_intersect, rb_difference };
+    size_t sizes[] = { 0, 1, 2, 10, 100, 1000 };
+    size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    unsigned seed = 42;
+
+    for (int op = 0; op < 3; op++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            for (size_t j = 0; j < count; j++)
+            {
+                // A narrow key range makes the trees overlap a lot, a wide
+                // one hardly at all
+                check(operations[op], sizes[i], sizes[j], 1500, 1, &seed);
+                check(operations[op], sizes[i], sizes[j], UNIVERSE, 2, &seed);
+            }
+        }
+    }
+}
+
+Test(rb_tree_set, runs_large_trees_on_several_threads)
+{
+    SetOperation operations[] = { rb_union, rb_intersect, rb_difference };
+    unsigned seed = 7;
+
+    for (int op = 0; op < 3; op++)
+    {
+        check(operations[op], 15000, 12000, UNIVERSE, 4, &seed);
+        check(operations[op], 12000, 15000, UNIVERSE, 3, &seed);
+        check(operations[op], 15000, 300, UNIVERSE, 8, &seed);
+        check(operations[op], 15000, 12000, UNIVERSE, 0, &seed);
+    }
+}
+
+Test(rb_tree_set, keeps_nodes_in_place)
+{
+    RB_Tree *a = rb_tree_new();
+    RB_Tree *b = rb_tree_new();
+    RB_Node *nodes[3000];
+    for (int i = 0; i < 3000; i++)
+    {
+        // a holds the even keys below 2000, b the other keys from 1000
+        nodes[i] = i < 2000 && i % 2 == 0 ? rb_insert(a, i)
+                 : i >= 1000              ? rb_insert(b, i)
+                                          : NULL;
+    }
+
+    RB_Tree *tree = rb_union(a, b, 4);
+    cr_assert_eq(rb_tree_size(tree), 2500);
+    for (int i = 0; i < 3000; i++)
+    {
+        if (nodes[i])
+        {
+            cr_assert_eq(rb_find(tree, i), nodes[i]);
+        }
+    }
+
+    // The result is an ordinary tree
+    cr_assert_not_null(rb_insert(tree, 1));
+    rb_delete(tree, rb_find(tree, 2000));
+    cr_assert_eq(rb_tree_size(tree), 2500);
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_set, works_on_trees_sharing_a_pool)
+{
+    RB_Tree *tree = rb_tree_new_with_pool(0);
+    for (int i = 0; i < 4000; i++)
+    {
+        cr_assert_not_null(rb_insert(tree, i));
+    }
+    RB_Tree *low;
+    RB_Tree *high;
+    cr_assert_eq(rb_split(tree, 2000, &low, &high), 0);
+
+    // Make the parts overlap on 1000..2999 and drop every third key of high
+    for (int i = 1000; i < 2000; i++)
+    {
+        cr_assert_not_null(rb_insert(high, i));
+    }
+    for (int i = 2000; i < 3000; i++)
+    {
+        cr_assert_not_null(rb_insert(low, i));
+    }
+    for (int i = 1000; i < 4000; i += 3)
+    {
+        rb_delete(high, rb_find(high, i));
+    }
+
+    RB_Tree *both = rb_intersect(low, high, 2);
+    cr_assert_not_null(both);
+    cr_assert_eq(rb_tree_size(both), 2000 - 667);
+    for (int i = 1000; i < 3000; i++)
+    {
+        cr_assert_eq(rb_find(both, i) != NULL, i % 3 != 1);
+    }
+
+    // The freed nodes went back to the pool
+    for (int i = 5000; i < 6000; i++)
+    {
+        cr_assert_not_null(rb_insert(both, i));
+    }
+    rb_tree_destroy(both);
+}
+
+Test(rb_tree_set, combines_trees_built_separately)
+{
+    static char expected[UNIVERSE];
+    static T evens[UNIVERSE / 2];
+    static T threes[UNIVERSE / 3 + 1];
+    for (int i = 0; i < UNIVERSE / 2; i++)
+    {
+        evens[i] = 2 * i;
+    }
+    for (int i = 0; 3 * i < UNIVERSE; i++)
+    {
+        threes[i] = 3 * i;
+    }
+
+    // Each built tree has a pool of its own, which the operation merges
+    SetOperation operations[] = { rb_union, rb_intersect, rb_difference };
+    for (int op = 0; op < 3; op++)
+    {
+        RB_Tree *a = rb_tree_build_sorted(evens, UNIVERSE / 2);
+        RB_Tree *b = rb_tree_build_sorted(threes, UNIVERSE / 3 + 1);
+        cr_assert_not_null(a);
+        cr_assert_not_null(b);
+        for (int k = 0; k < UNIVERSE; k++)
+        {
+            int in_a = k % 2 == 0;
+            int in_b = k % 3 == 0;
+            expected[k] = op == 0 ? in_a || in_b
+                        : op == 1 ? in_a && in_b
+                                  : in_a && !in_b;
+        }
+
+        RB_Tree *result = operations[op](a, b, 4);
+        cr_assert_not_null(result);
+        cr_assert(holds(result, expected));
+
+        // The merged pool keeps serving the result
+        for (int k = 1; k < UNIVERSE; k += 6)
+        {
+            cr_assert_not_null(rb_insert(result, k));
+        }
+        rb_tree_destroy(result);
+    }
+}
+
+Test(rb_tree_set, rejects_invalid_arguments)
+{
+    RB_Tree *a = rb_tree_new();
+    RB_Tree *pooled = rb_tree_new_with_pool(0);
+    cr_assert_not_null(rb_insert(a, 1));
+    cr_assert_not_null(rb_insert(pooled, 2));
+
+    cr_assert_null(rb_union(NULL, a, 1));
+    cr_assert_null(rb_intersect(a, NULL, 1));
+    cr_assert_null(rb_difference(a, a, 1));
+
+    // A pooled tree cannot take nodes that were allocated one by one
+    cr_assert_null(rb_union(a, pooled, 1));
+    cr_assert_eq(rb_tree_size(a), 1);
+    cr_assert_eq(rb_tree_size(pooled), 1);
+
+    rb_tree_destroy(a);
+    rb_tree_destroy(pooled);
+}
@@ -0,0 +1,160 @@
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+typedef struct
+{
+    int values[512];
+    size_t count;
+    size_t limit;
+} Collector;
+
+static int collect(RB_Node *node, void *ctx)
+{
+    Collector *collector = ctx;
+    collector->values[collector->count++] = node->data;
+    return collector->limit && collector->count == collector->limit;
+}
+
+TestSuite(rb_tree_sharded, .timeout = 10);
+
+Test(rb_tree_sharded, routes_keys_to_their_shard)
+{
+    int bounds[] = { 100, 200, 300 };
+    RB_Sharded *tree = rb_sharded_new(bounds, 3);
+    cr_assert_not_null(tree);
+
+    for (int i = -50; i < 350; i += 5)
+    {
+        cr_assert_eq(rb_sharded_insert(tree, i), 1);
+    }
+    cr_assert_eq(rb_sharded_insert(tree, 100), 0);
+    cr_assert_eq(rb_sharded_size(tree), 80);
+
+    for (int i = -50; i < 350; i++)
+    {
+        T out = -1000;
+        int expected = i % 5 == 0;
+        cr_assert_eq(rb_sharded_find(tree, i, &out), expected, "key %d", i);
+        cr_assert_eq(out, expected ? i : -1000);
+    }
+
+    // Bounds belong to the shard on their right
+    cr_assert_eq(rb_sharded_delete(tree, 200), 1);
+    cr_assert_eq(rb_sharded_delete(tree, 200), 0);
+    cr_assert_eq(rb_sharded_find(tree, 200, NULL), 0);
+    cr_assert_eq(rb_sharded_size(tree), 79);
+
+    rb_sharded_destroy(tree);
+}
+
+Test(rb_tree_sharded, visits_in_order_across_shards)
+{
+    int bounds[] = { 10, 20, 30, 40 };
+    RB_Sharded *tree = rb_sharded_new(bounds, 4);
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 50; i++)
+    {
+        rb_sharded_insert(tree, (i * 17) % 50);
+    }
+
+    Collector all = { { 0 }, 0, 0 };
+    cr_assert_eq(rb_sharded_visit(tree, collect, &all), 50);
+    for (int i = 0; i < 50; i++)
+    {
+        cr_assert_eq(all.values[i], i);
+    }
+
+    Collector range = { { 0 }, 0, 0 };
+    cr_assert_eq(rb_sharded_range(tree, 15, 35, collect, &range), 20);
+    for (int i = 0; i < 20; i++)
+    {
+        cr_assert_eq(range.values[i], 15 + i);
+    }
+
+    // Stopping in the middle of a shard ends the whole visit
+    Collector stopped = { { 0 }, 0, 12 };
+    cr_assert_eq(rb_sharded_range(tree, 5, 45, collect, &stopped), 12);
+    cr_assert_eq(stopped.values[11], 16);
+
+    Collector empty = { { 0 }, 0, 0 };
+    cr_assert_eq(rb_sharded_range(tree, 30, 30, collect, &empty), 0);
+
+    rb_sharded_destroy(tree);
+}
+
+Test(rb_tree_sharded, rejects_unsorted_bounds)
+{
+    int bounds[] = { 10, 10 };
+    cr_assert_null(rb_sharded_new(bounds, 2));
+    cr_assert_null(rb_sharded_new(NULL, 1));
+
+    // No bounds give a single shard
+    RB_Sharded *tree = rb_sharded_new(NULL, 0);
+    cr_assert_not_null(tree);
+    cr_assert_eq(rb_sharded_insert(tree, 7), 1);
+    cr_assert_eq(rb_sharded_find(tree, 7, NULL), 1);
+    rb_sharded_destroy(tree);
+
+    cr_assert_eq(rb_sharded_insert(NULL, 1), -1);
+    cr_assert_eq(rb_sharded_find(NULL, 1, NULL), 0);
+    cr_assert_eq(rb_sharded_delete(NULL, 1), 0);
+    cr_assert_eq(rb_sharded_size(NULL), 0);
+    cr_assert_eq(rb_sharded_visit(NULL, collect, NULL), 0);
+    rb_sharded_destroy(NULL);
+}
+
+typedef struct
+{
+    RB_Sharded *tree;
+    int first;
+} Writer;
+
+static void *insert_slice(void *arg)
+{
+    Writer *writer = arg;
+    for (int i = writer->first; i < 4000; i += 4)
+    {
+        rb_sharded_insert(writer->tree, i);
+    }
+    for (int i = writer->first; i < 4000; i += 8)
+    {
+        rb_sharded_delete(writer->tree, i);
+    }
+    return NULL;
+}
+
+Test(rb_tree_sharded, writers_share_the_tree)
+{
+    int bounds[] = { 1000, 2000, 3000 };
+    RB_Sharded *tree = rb_sharded_new(bounds, 3);
+    cr_assert_not_null(tree);
+
+    pthread_t threads[4];
+    Writer writers[4];
+    for (int i = 0; i < 4; i++)
+    {
+        writers[i].tree = tree;
+        writers[i].first = i;
+        cr_assert_eq(pthread_create(&threads[i], NULL, insert_slice,
+                                    &writers[i]),
+                     0);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Each writer deleted every other key it inserted
+    cr_assert_eq(rb_sharded_size(tree), 2000);
+    for (int i = 0; i < 4000; i++)
+    {
+        cr_assert_eq(rb_sharded_find(tree, i, NULL), (i / 4) % 2 == 1,
+                     "key %d", i);
+    }
+
+    rb_sharded_destroy(tree);
+}
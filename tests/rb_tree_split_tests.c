@@ -0,0 +1,239 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+#include "rb_tree_test_helpers.h"
+
+/* Whether tree is a valid red black tree holding exactly lo, lo + step...
+ * below hi */
+static int holds(RB_Tree *tree, int lo, int hi, int step)
+{
+    if (!rb_test_validate(tree))
+    {
+        return 0;
+    }
+
+    int expected = lo;
+    for (RB_Node *node = rb_first(tree); node; node = rb_next(tree, node))
+    {
+        if (expected >= hi || node->data != expected)
+        {
+            return 0;
+        }
+        expected += step;
+    }
+    size_t size = hi > lo ? (size_t)((hi - lo + step - 1) / step) : 0;
+    return expected >= hi && rb_tree_size(tree) == size;
+}
+
+static RB_Tree *tree_of(int lo, int hi, int step, int pooled)
+{
+    RB_Tree *tree = pooled ? rb_tree_new_with_pool(0) : rb_tree_new();
+    cr_assert_not_null(tree);
+    for (int i = lo; i < hi; i += step)
+    {
+        cr_assert_not_null(rb_insert(tree, i));
+    }
+    return tree;
+}
+
+TestSuite(rb_tree_split, .timeout = 20);
+
+Test(rb_tree_split, splits_at_every_key_and_concatenates_back)
+{
+    for (int n = 0; n < 70; n++)
+    {
+        for (int key = -1; key <= 2 * n + 1; key++)
+        {
+            // Keys 0, 2, 4... so that odd keys are absent
+            RB_Tree *tree = tree_of(0, 2 * n, 2, n % 2);
+            RB_Tree *left;
+            RB_Tree *right;
+            cr_assert_eq(rb_split(tree, key, &left, &right), 0);
+            cr_assert(left == tree || right == tree);
+            cr_assert_neq(left, right);
+
+            int cut = key < 0 ? 0 : (key + 1) / 2 * 2;
+            if (cut > 2 * n)
+            {
+                cut = 2 * n;
+            }
+            cr_assert(holds(left, 0, cut, 2), "n=%d key=%d", n, key);
+            cr_assert(holds(right, cut, 2 * n, 2), "n=%d key=%d", n, key);
+
+            RB_Tree *joined = rb_concat(left, right);
+            cr_assert_not_null(joined);
+            cr_assert(holds(joined, 0, 2 * n, 2));
+            rb_tree_destroy(joined);
+        }
+    }
+}
+
+Test(rb_tree_split, keeps_nodes_in_place)
+{
+    RB_Tree *tree = tree_of(0, 1000, 1, 0);
+    RB_Node *nodes[1000];
+    for (int i = 0; i < 1000; i++)
+    {
+        nodes[i] = rb_find(tree, i);
+    }
+
+    RB_Tree *left;
+    RB_Tree *right;
+    cr_assert_eq(rb_split(tree, 300, &left, &right), 0);
+    cr_assert_eq(right, tree);
+    for (int i = 0; i < 1000; i++)
+    {
+        cr_assert_eq(rb_find(i < 300 ? left : right, i), nodes[i]);
+        cr_assert_null(rb_find(i < 300 ? right : left, i));
+    }
+
+    // Both parts are ordinary trees
+    cr_assert_not_null(rb_insert(left, -5));
+    rb_delete(right, rb_find(right, 500));
+    cr_assert_eq(rb_tree_size(left), 301);
+    cr_assert_eq(rb_tree_size(right), 699);
+
+    rb_tree_destroy(left);
+    rb_tree_destroy(right);
+}
+
+Test(rb_tree_split, joins_trees_of_any_heights)
+{
+    int sizes[] = { 0, 1, 2, 5, 31, 100, 1000 };
+    int count = sizeof(sizes) / sizeof(sizes[0]);
+    for (int a = 0; a < count; a++)
+    {
+        for (int b = 0; b < count; b++)
+        {
+            RB_Tree *left = tree_of(0, sizes[a], 1, 0);
+            RB_Tree *right =
+                tree_of(sizes[a] + 1, sizes[a] + 1 + sizes[b], 1, 0);
+            RB_Tree *joined = rb_join(left, sizes[a], right);
+            cr_assert_not_null(joined);
+            cr_assert(holds(joined, 0, sizes[a] + 1 + sizes[b], 1));
+            rb_tree_destroy(joined);
+        }
+    }
+}
+
+Test(rb_tree_split, rejects_unordered_or_foreign_trees)
+{
+    RB_Tree *left = tree_of(0, 10, 1, 0);
+    RB_Tree *right = tree_of(20, 30, 1, 0);
+
+    cr_assert_null(rb_join(left, 5, right));
+    cr_assert_null(rb_join(left, 25, right));
+    cr_assert_null(rb_join(right, 15, left));
+    cr_assert_null(rb_concat(right, left));
+    cr_assert_null(rb_join(left, 15, left));
+    cr_assert(holds(left, 0, 10, 1));
+    cr_assert(holds(right, 20, 30, 1));
+
+    // A pooled tree cannot take nodes that were allocated one by one
+    RB_Tree *pooled = tree_of(40, 50, 1, 1);
+    cr_assert_null(rb_concat(right, pooled));
+    cr_assert(holds(pooled, 40, 50, 1));
+
+    RB_Tree *joined = rb_join(left, 15, right);
+    cr_assert_not_null(joined);
+    cr_assert_eq(rb_tree_size(joined), 21);
+
+    rb_tree_destroy(pooled);
+    rb_tree_destroy(joined);
+}
+
+Test(rb_tree_split, parts_share_the_pool)
+{
+    RB_Tree *tree = tree_of(0, 5000, 1, 1);
+    RB_Tree *left;
+    RB_Tree *right;
+    cr_assert_eq(rb_split(tree, 4000, &left, &right), 0);
+
+    // The part destroyed first gives its nodes back to the pool, which the
+    // other part keeps using
+    rb_tree_destroy(right);
+    for (int i = 5000; i < 6000; i++)
+    {
+        cr_assert_not_null(rb_insert(left, i));
+    }
+    for (int i = 0; i < 4000; i += 2)
+    {
+        rb_delete(left, rb_find(left, i));
+    }
+    cr_assert_eq(rb_tree_size(left), 3000);
+    rb_tree_destroy(left);
+}
+
+Test(rb_tree_split, joins_trees_of_separate_pools)
+{
+    // The small tree has the most room left in its pool, the large one
+    // recycles deleted nodes
+    RB_Tree *left = rb_tree_new_with_pool(4096);
+    cr_assert_not_null(left);
+    for (int i = 0; i < 10; i++)
+    {
+        cr_assert_not_null(rb_insert(left, i));
+    }
+    RB_Tree *right = tree_of(11, 3000, 1, 1);
+    for (int i = 2000; i < 3000; i++)
+    {
+        rb_delete(right, rb_find(right, i));
+    }
+
+    RB_Tree *joined = rb_join(left, 10, right);
+    cr_assert_not_null(joined);
+    cr_assert(holds(joined, 0, 2000, 1));
+
+    // Both pools serve and take back nodes of the joined tree
+    for (int i = 2000; i < 10000; i++)
+    {
+        cr_assert_not_null(rb_insert(joined, i));
+    }
+    for (int i = 0; i < 10000; i += 2)
+    {
+        rb_delete(joined, rb_find(joined, i));
+    }
+    cr_assert(holds(joined, 1, 10000, 2));
+    rb_tree_destroy(joined);
+}
+
+Test(rb_tree_split, rejects_pools_that_other_trees_share)
+{
+    RB_Tree *a = tree_of(0, 100, 1, 1);
+    RB_Tree *b = tree_of(100, 200, 1, 1);
+    RB_Tree *a_low, *a_high, *b_low, *b_high;
+    cr_assert_eq(rb_split(a, 50, &a_low, &a_high), 0);
+    cr_assert_eq(rb_split(b, 150, &b_low, &b_high), 0);
+
+    // Merging either pool would pull it from under its other part
+    cr_assert_null(rb_concat(a_high, b_low));
+    cr_assert(holds(a_high, 50, 100, 1));
+    cr_assert(holds(b_low, 100, 150, 1));
+
+    // Once a part is gone, the pool of the other one can be merged
+    a = rb_concat(a_low, a_high);
+    cr_assert_not_null(a);
+    a = rb_concat(a, b_low);
+    cr_assert_not_null(a);
+    a = rb_concat(a, b_high);
+    cr_assert_not_null(a);
+    cr_assert(holds(a, 0, 200, 1));
+    rb_tree_destroy(a);
+}
+
+Test(rb_tree_split, handles_null_arguments)
+{
+    RB_Tree *tree = tree_of(0, 10, 1, 0);
+    RB_Tree *part;
+    cr_assert_eq(rb_split(NULL, 0, &part, &part), -1);
+    cr_assert_eq(rb_split(tree, 0, NULL, &part), -1);
+    cr_assert_eq(rb_split(tree, 0, &part, NULL), -1);
+    cr_assert_null(rb_join(NULL, 0, tree));
+    cr_assert_null(rb_join(tree, 20, NULL));
+    cr_assert_null(rb_concat(NULL, tree));
+    cr_assert_null(rb_concat(tree, NULL));
+    cr_assert(holds(tree, 0, 10, 1));
+    rb_tree_destroy(tree);
+}
@@ -0,0 +1,120 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+#ifdef RB_STATS
+
+static unsigned long histogram_total(const RB_Stats *stats)
+{
+    unsigned long total = 0;
+    for (int i = 0; i < RB_STATS_DEPTHS; i++)
+    {
+        total += stats->depths[i];
+    }
+    return total;
+}
+
+TestSuite(rb_tree_stats, .timeout = 10);
+
+Test(rb_tree_stats, counts_rotations_and_fixups)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    RB_Stats stats;
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.inserts, 0);
+    cr_assert_eq(stats.size, 0);
+    cr_assert_eq(stats.height, 0);
+
+    // 3 goes under the red 2, which one left rotation at 1 fixes
+    rb_insert(tree, 1);
+    rb_insert(tree, 2);
+    rb_insert(tree, 3);
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.inserts, 3);
+    cr_assert_eq(stats.insert_fixups, 1);
+    cr_assert_eq(stats.rotations_left, 1);
+    cr_assert_eq(stats.rotations_right, 0);
+    cr_assert_eq(stats.size, 3);
+    cr_assert_eq(stats.height, 2);
+    cr_assert_eq(stats.black_height, 1);
+
+    // Descents of 0, 1 and 2 comparisons
+    cr_assert_eq(stats.descents, 3);
+    cr_assert_eq(stats.comparisons, 3);
+    cr_assert_eq(stats.depths[0], 1);
+    cr_assert_eq(stats.depths[1], 1);
+    cr_assert_eq(stats.depths[2], 1);
+
+    rb_delete(tree, rb_find(tree, 1));
+    rb_delete(tree, rb_find(tree, 3));
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.deletes, 2);
+    cr_assert_eq(stats.size, 1);
+    cr_assert_eq(stats.descents, 5);
+    cr_assert_eq(stats.depths[2], 3);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_stats, depths_stay_within_the_red_black_bound)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    for (int i = 0; i < 10000; i++)
+    {
+        rb_insert(tree, i);
+    }
+    for (int i = 0; i < 10000; i++)
+    {
+        cr_assert_not_null(rb_find(tree, i));
+        cr_assert_not_null(rb_lower_bound(tree, i));
+    }
+
+    RB_Stats stats;
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.inserts, 10000);
+    cr_assert_eq(stats.descents, 30000);
+    cr_assert_eq(histogram_total(&stats), stats.descents);
+    cr_assert_eq(stats.rotations_left + stats.rotations_right > 0, 1);
+
+    // A red black tree of n nodes is at most 2 log2(n + 1) high, and every
+    // path holds at least black_height nodes
+    cr_assert_lt(stats.height, 2 * 14 + 1);
+    cr_assert_eq(stats.height >= stats.black_height, 1);
+    unsigned long weighted = 0;
+    for (size_t depth = 0; depth < RB_STATS_DEPTHS; depth++)
+    {
+        weighted += depth * stats.depths[depth];
+        if (depth > stats.height)
+        {
+            cr_assert_eq(stats.depths[depth], 0);
+        }
+    }
+    cr_assert_eq(weighted, stats.comparisons);
+
+    rb_tree_stats_reset(tree);
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.inserts, 0);
+    cr_assert_eq(stats.descents, 0);
+    cr_assert_eq(histogram_total(&stats), 0);
+    cr_assert_eq(stats.size, 10000);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_stats, handles_null_arguments)
+{
+    RB_Stats stats;
+    cr_assert_eq(rb_tree_stats(NULL, &stats), -1);
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+    cr_assert_eq(rb_tree_stats(tree, NULL), -1);
+    rb_tree_stats_reset(NULL);
+    rb_tree_destroy(tree);
+}
+
+#endif // RB_STATS
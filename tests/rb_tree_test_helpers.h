@@ -0,0 +1,69 @@
+#ifndef RB_TREE_TEST_HELPERS_H
+#define RB_TREE_TEST_HELPERS_H
+
+#include "../rb_tree.h"
+
+/* Black height of the subtree of node, or -1 when it breaks a rule: a child
+ * that does not point back at its parent or whose key is on the wrong side,
+ * a red node with a red child, a subtree size that does not add up, or a
+ * path deeper than any valid tree, which is what a node pointing at the nil
+ * node of another tree runs into */
+static inline int rb_test_black_height(RB_Tree *tree, RB_Node *node,
+                                       int depth)
+{
+    RB_Node *nil = &tree->nil;
+    if (node == nil)
+    {
+        return 1;
+    }
+    if (depth > 128)
+    {
+        return -1;
+    }
+
+    if ((node->left != nil && rb_parent(node->left) != node)
+        || (node->right != nil && rb_parent(node->right) != node))
+    {
+        return -1;
+    }
+    if ((node->left != nil && compCMP(node->left->data, node->data) >= 0)
+        || (node->right != nil && compCMP(node->data, node->right->data) >= 0))
+    {
+        return -1;
+    }
+    if (rb_color(node) == RED
+        && (rb_color(node->left) == RED || rb_color(node->right) == RED))
+    {
+        return -1;
+    }
+#ifdef RB_ORDER_STATISTICS
+    if (node->size != node->left->size + node->right->size + 1)
+    {
+        return -1;
+    }
+#endif // RB_ORDER_STATISTICS
+
+    int left = rb_test_black_height(tree, node->left, depth + 1);
+    int right = rb_test_black_height(tree, node->right, depth + 1);
+    if (left < 0 || left != right)
+    {
+        return -1;
+    }
+    return left + (rb_color(node) == BLACK ? 1 : 0);
+}
+
+/* Whether tree is a valid red black tree */
+static inline int rb_test_validate(RB_Tree *tree)
+{
+    if (tree->root == &tree->nil)
+    {
+        return 1;
+    }
+    if (rb_parent(tree->root) != NULL || rb_color(tree->root) != BLACK)
+    {
+        return 0;
+    }
+    return rb_test_black_height(tree, tree->root, 0) > 0;
+}
+
+#endif // RB_TREE_TEST_HELPERS_H
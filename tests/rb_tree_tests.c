@@ -3,59 +3,7 @@
 #include <stdio.h>
 
 #include "../rb_tree.h"
-
-// Helper function to validate the red-black properties recursively
-static int validateRBTree(RB_Tree *tree, RB_Node *node, int blackCount,
-                          int *pathBlackCount)
-{
-    if (node == &tree->nil)
-    {
-        // When reaching a leaf (nil), check if the number of black nodes is
-        // consistent
-        if (*pathBlackCount == -1)
-        {
-            *pathBlackCount = blackCount;
-        }
-        return *pathBlackCount == blackCount;
-    }
-
-    // Red nodes cannot have red children
-    if (node->color == RED)
-    {
-        if ((node->left != NULL && node->left->color == RED)
-            || (node->right != NULL && node->right->color == RED))
-        {
-            return 0;
-        }
-    }
-    else
-    {
-        // Increment black count for black nodes
-        blackCount++;
-    }
-
-    // Recursively validate left and right subtrees
-    return validateRBTree(tree, node->left, blackCount, pathBlackCount)
-        && validateRBTree(tree, node->right, blackCount, pathBlackCount);
-}
-
-int rb_validate(RB_Tree *tree)
-{
-    if (tree == NULL || tree->root == NULL)
-    {
-        // An empty tree is a valid red-black tree
-        return 1;
-    }
-
-    // The root must be black
-    if (tree->root->color != BLACK)
-    {
-        return 0;
-    }
-
-    int pathBlackCount = -1;
-    return validateRBTree(tree, tree->root, 0, &pathBlackCount);
-}
+#include "rb_tree_test_helpers.h"
 
 int is_unique(int *arr, int size, int num)
 {
@@ -103,8 +51,8 @@ Test(rb_tree_new, should_create_a_new_rb_tree)
     cr_assert_not_null(tree);
     cr_assert_eq(tree->nil.left, &tree->nil);
     cr_assert_eq(tree->nil.right, &tree->nil);
-    cr_assert_eq(tree->nil.parent, &tree->nil);
-    cr_assert_eq(tree->nil.color, BLACK);
+    cr_assert_eq(rb_parent(&tree->nil), &tree->nil);
+    cr_assert_eq(rb_color(&tree->nil), BLACK);
     cr_assert_eq(tree->nil.data, 0);
     cr_assert_eq(tree->root, &tree->nil);
 
@@ -121,13 +69,13 @@ Test(rb_tree_insert, should_insert_a_node_in_the_tree)
 
     cr_assert_not_null(node);
     cr_assert_eq(node->data, 42);
-    cr_assert_eq(node->color, BLACK);
+    cr_assert_eq(rb_color(node), BLACK);
     cr_assert_eq(node->left, &tree->nil);
     cr_assert_eq(node->right, &tree->nil);
-    cr_assert_eq(node->parent, NULL);
+    cr_assert_eq(rb_parent(node), NULL);
     cr_assert_eq(tree->root, node);
 
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -141,21 +89,21 @@ Test(rb_tree_insert, should_insert_a_node_in_the_tree_2)
 
     cr_assert_not_null(node);
     cr_assert_eq(node->data, 42);
-    cr_assert_eq(node->color, BLACK);
+    cr_assert_eq(rb_color(node), BLACK);
     cr_assert_eq(node->left, node2);
     cr_assert_eq(node->right, &tree->nil);
-    cr_assert_eq(node->parent, NULL);
+    cr_assert_eq(rb_parent(node), NULL);
     cr_assert_eq(tree->root, node);
 
     cr_assert_not_null(node2);
     cr_assert_eq(node2->data, 21);
-    cr_assert_eq(node2->color, RED);
+    cr_assert_eq(rb_color(node2), RED);
     cr_assert_eq(node2->left, &tree->nil);
     cr_assert_eq(node2->right, &tree->nil);
-    cr_assert_eq(node2->parent, node);
+    cr_assert_eq(rb_parent(node2), node);
     cr_assert_eq(node->left, node2);
 
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -170,29 +118,29 @@ Test(rb_tree_insert, should_insert_a_node_in_the_tree_3)
 
     cr_assert_not_null(node);
     cr_assert_eq(node->data, 42);
-    cr_assert_eq(node->color, BLACK);
+    cr_assert_eq(rb_color(node), BLACK);
     cr_assert_eq(node->left, node2);
     cr_assert_eq(node->right, node3);
-    cr_assert_eq(node->parent, NULL);
+    cr_assert_eq(rb_parent(node), NULL);
     cr_assert_eq(tree->root, node);
 
     cr_assert_not_null(node2);
     cr_assert_eq(node2->data, 21);
-    cr_assert_eq(node2->color, RED);
+    cr_assert_eq(rb_color(node2), RED);
     cr_assert_eq(node2->left, &tree->nil);
     cr_assert_eq(node2->right, &tree->nil);
-    cr_assert_eq(node2->parent, node);
+    cr_assert_eq(rb_parent(node2), node);
     cr_assert_eq(node->left, node2);
 
     cr_assert_not_null(node3);
     cr_assert_eq(node3->data, 84);
-    cr_assert_eq(node3->color, RED);
+    cr_assert_eq(rb_color(node3), RED);
     cr_assert_eq(node3->left, &tree->nil);
     cr_assert_eq(node3->right, &tree->nil);
-    cr_assert_eq(node3->parent, node);
+    cr_assert_eq(rb_parent(node3), node);
     cr_assert_eq(node->right, node3);
 
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -222,12 +170,12 @@ Test(rb_tree_insert, right_insertion_rotation)
     // Check the properties of each node (color, parent, children)
     // Example: node2 should now be black (as the root), and its children should
     // be red
-    cr_assert_eq(node2->color, BLACK);
-    cr_assert_eq(node1->color, RED);
-    cr_assert_eq(node3->color, RED);
+    cr_assert_eq(rb_color(node2), BLACK);
+    cr_assert_eq(rb_color(node1), RED);
+    cr_assert_eq(rb_color(node3), RED);
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -257,12 +205,12 @@ Test(rb_tree_insert, left_insertion_rotation)
     // Check the properties of each node (color, parent, children)
     // Example: node2 should now be black (as the root), and its children should
     // be red
-    cr_assert_eq(node2->color, BLACK);
-    cr_assert_eq(node1->color, RED);
-    cr_assert_eq(node3->color, RED);
+    cr_assert_eq(rb_color(node2), BLACK);
+    cr_assert_eq(rb_color(node1), RED);
+    cr_assert_eq(rb_color(node3), RED);
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -280,7 +228,7 @@ Test(rb_tree_insert, random_insertions_10)
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -301,7 +249,7 @@ Test(rb_tree_insert, random_insertions_100)
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
     free(values);
@@ -323,7 +271,7 @@ Test(rb_tree_insert, random_insertions_1000)
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
     free(values);
@@ -566,7 +514,7 @@ Test(rb_delete, should_delete_a_node_from_the_tree_5)
     cr_assert_eq(tree->root->right->left->right->data, 6);
     cr_assert_eq(tree->root->right->right->right->data, 84);
 
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
 }
@@ -585,18 +533,18 @@ Test(random_operations, should_insert_and_delete_randomly_10)
 
     for (int i = 0; i < 10; i++)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_insert(tree, values[i]);
     }
 
     for (int i = 0; i < 10; i++)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_delete(tree, rb_find(tree, values[i]));
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
     free(values);
@@ -614,18 +562,18 @@ Test(random_operations, should_insert_and_delete_randomly_100)
 
     for (int i = 0; i < 100; i++)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_insert(tree, values[i]);
     }
 
     for (int i = 0; i < 100; i++)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_delete(tree, rb_find(tree, values[i]));
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
     free(values);
@@ -643,18 +591,18 @@ Test(random_operations, should_insert_and_delete_randomly_1000)
 
     for (int i = 0; i < 1000; i++)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_insert(tree, values[i]);
     }
 
     for (int i = 999; i >= 0; i--)
     {
-        cr_assert_eq(rb_validate(tree), 1);
+        cr_assert_eq(rb_test_validate(tree), 1);
         rb_delete(tree, rb_find(tree, values[i]));
     }
 
     // Validate the entire tree
-    cr_assert_eq(rb_validate(tree), 1);
+    cr_assert_eq(rb_test_validate(tree), 1);
 
     rb_tree_destroy(tree);
     free(values);
@@ -0,0 +1,124 @@
+#include <criterion/criterion.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rb_tree.h"
+
+TestSuite(rb_tree_upsert, .timeout = 10);
+
+Test(rb_tree_upsert, find_or_insert_tells_whether_it_created_the_node)
+{
+    RB_Tree *tree = rb_tree_new();
+    cr_assert_not_null(tree);
+
+    int inserted = -1;
+    RB_Node *node = rb_find_or_insert(tree, 42, &inserted);
+    cr_assert_not_null(node);
+    cr_assert_eq(inserted, 1);
+    cr_assert_eq(node->data, 42);
+
+    inserted = -1;
+    cr_assert_eq(rb_find_or_insert(tree, 42, &inserted), node);
+    cr_assert_eq(inserted, 0);
+    cr_assert_eq(rb_tree_size(tree), 1);
+
+    // inserted may be NULL
+    cr_assert_not_null(rb_find_or_insert(tree, 7, NULL));
+    cr_assert_eq(rb_tree_size(tree), 2);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_upsert, upsert_overwrites_in_place)
+{
+    RB_Tree *tree = rb_tree_new();
+    for (int i = 0; i < 100; i++)
+    {
+        cr_assert_not_null(rb_insert(tree, i));
+    }
+    RB_Node *node = rb_find(tree, 50);
+    unsigned long generation = tree->generation;
+
+    int inserted = -1;
+    cr_assert_eq(rb_upsert(tree, 50, &inserted), node);
+    cr_assert_eq(inserted, 0);
+    cr_assert_eq(rb_tree_size(tree), 100);
+
+    // An overwrite makes frozen snapshots stale
+    cr_assert_neq(tree->generation, generation);
+
+    RB_Node *created = rb_upsert(tree, 500, &inserted);
+    cr_assert_not_null(created);
+    cr_assert_eq(inserted, 1);
+    cr_assert_eq(rb_find(tree, 500), created);
+    cr_assert_eq(rb_tree_size(tree), 101);
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_upsert, erase_tells_whether_it_removed_the_key)
+{
+    RB_Tree *tree = rb_tree_new();
+    RB_Node *nodes[64];
+    for (int i = 0; i < 64; i++)
+    {
+        nodes[i] = rb_insert(tree, i);
+    }
+
+    for (int i = 0; i < 64; i += 2)
+    {
+        cr_assert_eq(rb_erase(tree, i), 1);
+        cr_assert_eq(rb_erase(tree, i), 0);
+    }
+    cr_assert_eq(rb_erase(tree, 1000), 0);
+    cr_assert_eq(rb_tree_size(tree), 32);
+
+    // The other nodes stay where they were
+    for (int i = 1; i < 64; i += 2)
+    {
+        cr_assert_eq(rb_find(tree, i), nodes[i]);
+    }
+
+    rb_tree_destroy(tree);
+}
+
+Test(rb_tree_upsert, handles_null_tree)
+{
+    int inserted = -1;
+    cr_assert_null(rb_find_or_insert(NULL, 1, &inserted));
+    cr_assert_eq(inserted, 0);
+    inserted = -1;
+    cr_assert_null(rb_upsert(NULL, 1, &inserted));
+    cr_assert_eq(inserted, 0);
+    cr_assert_eq(rb_erase(NULL, 1), 0);
+}
+
+#ifdef RB_STATS
+
+Test(rb_tree_upsert, each_call_descends_once)
+{
+    RB_Tree *tree = rb_tree_new();
+    for (int i = 0; i < 1000; i++)
+    {
+        rb_insert(tree, i);
+    }
+    rb_tree_stats_reset(tree);
+
+    int inserted;
+    rb_find_or_insert(tree, 500, &inserted);
+    rb_find_or_insert(tree, 5000, &inserted);
+    rb_upsert(tree, 600, &inserted);
+    rb_upsert(tree, 6000, &inserted);
+    rb_erase(tree, 700);
+    rb_erase(tree, 7000);
+
+    RB_Stats stats;
+    cr_assert_eq(rb_tree_stats(tree, &stats), 0);
+    cr_assert_eq(stats.descents, 6);
+    cr_assert_eq(stats.inserts, 2);
+    cr_assert_eq(stats.deletes, 1);
+
+    rb_tree_destroy(tree);
+}
+
+#endif // RB_STATS